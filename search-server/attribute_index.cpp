@@ -0,0 +1,62 @@
+#include "attribute_index.h"
+
+using namespace std;
+
+void AttributeIndex::AddDocument(int document_id, DocumentStatus status, int rating) {
+    all_documents_.Add(document_id);
+    status_to_documents_[static_cast<int>(status)].Add(document_id);
+    rating_to_documents_[rating].Add(document_id);
+}
+
+void AttributeIndex::RemoveDocument(int document_id, DocumentStatus status, int rating) {
+    all_documents_.Remove(document_id);
+    status_to_documents_[static_cast<int>(status)].Remove(document_id);
+    const auto it = rating_to_documents_.find(rating);
+    if (it == rating_to_documents_.end()) {
+        return;
+    }
+    it->second.Remove(document_id);
+    if (it->second.empty()) {
+        rating_to_documents_.erase(it);
+    }
+}
+
+RoaringBitmap AttributeIndex::Select(const DocumentFilter& filter) const {
+    RoaringBitmap result;
+    if (filter.statuses.empty()) {
+        result = all_documents_;
+    } else {
+        for (const DocumentStatus status : filter.statuses) {
+            result |= status_to_documents_[static_cast<int>(status)];
+        }
+    }
+    if (filter.min_rating > filter.max_rating) {
+        return {};
+    }
+    if (filter.min_rating == numeric_limits<int>::min() && filter.max_rating == numeric_limits<int>::max()) {
+        return result;
+    }
+
+    const auto range_begin = rating_to_documents_.lower_bound(filter.min_rating);
+    const auto range_end = rating_to_documents_.upper_bound(filter.max_rating);
+    size_t in_range_count = 0;
+    for (auto it = range_begin; it != range_end; ++it) {
+        in_range_count += it->second.Count();
+    }
+
+    if (in_range_count * 2 <= all_documents_.Count()) {
+        RoaringBitmap in_range;
+        for (auto it = range_begin; it != range_end; ++it) {
+            in_range |= it->second;
+        }
+        result &= in_range;
+    } else {
+        for (auto it = rating_to_documents_.begin(); it != range_begin; ++it) {
+            result -= it->second;
+        }
+        for (auto it = range_end; it != rating_to_documents_.end(); ++it) {
+            result -= it->second;
+        }
+    }
+    return result;
+}
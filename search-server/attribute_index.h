@@ -0,0 +1,27 @@
+#pragma once
+#include <limits>
+#include <map>
+#include <vector>
+#include "document.h"
+#include "roaring_bitmap.h"
+
+struct DocumentFilter {
+    std::vector<DocumentStatus> statuses;
+    int min_rating = std::numeric_limits<int>::min();
+    int max_rating = std::numeric_limits<int>::max();
+};
+
+class AttributeIndex {
+public:
+    void AddDocument(int document_id, DocumentStatus status, int rating);
+
+    void RemoveDocument(int document_id, DocumentStatus status, int rating);
+
+    RoaringBitmap Select(const DocumentFilter& filter) const;
+private:
+    static const int STATUS_COUNT = static_cast<int>(DocumentStatus::REMOVED) + 1;
+
+    RoaringBitmap all_documents_;
+    std::vector<RoaringBitmap> status_to_documents_ = std::vector<RoaringBitmap>(STATUS_COUNT);
+    std::map<int, RoaringBitmap> rating_to_documents_;
+};
@@ -1,4 +1,5 @@
 #pragma once
+#include <optional>
 #include <vector>
 #include <string>
 #include <iostream>
@@ -15,6 +16,17 @@ struct Document {
 
 std::ostream& operator<<(std::ostream& out, const Document& document);
 
+struct PageCursor {
+    double relevance = 0.0;
+    int rating = 0;
+    int id = 0;
+};
+
+struct DocumentPage {
+    std::vector<Document> documents;
+    std::optional<PageCursor> next_cursor;
+};
+
 enum class DocumentStatus {
     ACTUAL,
     IRRELEVANT,
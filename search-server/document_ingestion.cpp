@@ -0,0 +1,182 @@
+#include "document_ingestion.h"
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include "bounded_queue.h"
+
+using namespace std;
+
+struct DocumentBatch {
+    vector<char> text;
+    vector<PreparedDocument> documents;
+};
+
+static int ParseRecordNumber(string_view text, string_view record) {
+    int value = 0;
+    const auto [end, error] = from_chars(text.data(), text.data() + text.size(), value);
+    if (text.empty() || error != errc() || end != text.data() + text.size()) {
+        throw invalid_argument("Invalid document record: "s + string{record});
+    }
+    return value;
+}
+
+static DocumentStatus ParseRecordStatus(string_view text, string_view record) {
+    if (text == "ACTUAL"sv) {
+        return DocumentStatus::ACTUAL;
+    }
+    if (text == "IRRELEVANT"sv) {
+        return DocumentStatus::IRRELEVANT;
+    }
+    if (text == "BANNED"sv) {
+        return DocumentStatus::BANNED;
+    }
+    if (text == "REMOVED"sv) {
+        return DocumentStatus::REMOVED;
+    }
+    throw invalid_argument("Invalid document record: "s + string{record});
+}
+
+static string_view NextRecordField(string_view& rest, string_view record) {
+    const size_t tab = rest.find('\t');
+    if (tab == rest.npos) {
+        throw invalid_argument("Invalid document record: "s + string{record});
+    }
+    const string_view field = rest.substr(0, tab);
+    rest.remove_prefix(tab + 1);
+    return field;
+}
+
+static PreparedDocument PrepareRecord(const SearchServer& search_server, string_view record) {
+    string_view rest = record;
+    const int document_id = ParseRecordNumber(NextRecordField(rest, record), record);
+    const DocumentStatus status = ParseRecordStatus(NextRecordField(rest, record), record);
+    vector<int> ratings;
+    for (const string_view rating : SplitIntoWords(NextRecordField(rest, record))) {
+        ratings.push_back(ParseRecordNumber(rating, record));
+    }
+    return search_server.PrepareDocument(document_id, rest, status, ratings);
+}
+
+size_t IngestDocuments(SearchServer& search_server, istream& input, const IngestionOptions& options) {
+    return IngestDocuments(ThreadPool::GetDefault(), search_server, input, options);
+}
+
+size_t IngestDocuments(ThreadPool& pool, SearchServer& search_server, istream& input, const IngestionOptions& options) {
+    if (options.chunk_size == 0) {
+        throw invalid_argument("Chunk size must be positive"s);
+    }
+    BoundedQueue<vector<char>> chunks(options.queue_capacity);
+    BoundedQueue<DocumentBatch> batches(options.queue_capacity);
+
+    mutex error_mutex;
+    exception_ptr first_error;
+    atomic<bool> has_error = false;
+    const auto fail = [&](exception_ptr error) {
+        {
+            lock_guard guard(error_mutex);
+            if (!first_error) {
+                first_error = error;
+            }
+        }
+        has_error = true;
+        chunks.Close();
+        batches.Close();
+    };
+
+    thread reader([&] {
+        try {
+            vector<char> carry;
+            while (!has_error) {
+                vector<char> chunk = move(carry);
+                carry = {};
+                const size_t offset = chunk.size();
+                chunk.resize(offset + options.chunk_size);
+                input.read(chunk.data() + offset, options.chunk_size);
+                chunk.resize(offset + input.gcount());
+                if (!input) {
+                    if (input.bad()) {
+                        throw runtime_error("Failed to read documents"s);
+                    }
+                    if (!chunk.empty()) {
+                        chunks.Push(move(chunk));
+                    }
+                    break;
+                }
+                const auto last_newline = find(chunk.rbegin(), chunk.rend(), '\n');
+                if (last_newline == chunk.rend()) {
+                    carry = move(chunk);
+                    continue;
+                }
+                const auto chunk_end = last_newline.base();
+                carry.assign(chunk_end, chunk.end());
+                chunk.erase(chunk_end, chunk.end());
+                if (!chunks.Push(move(chunk))) {
+                    break;
+                }
+            }
+        } catch (...) {
+            fail(current_exception());
+        }
+        chunks.Close();
+    });
+
+    size_t document_count = 0;
+    thread indexer([&] {
+        try {
+            while (auto batch = batches.Pop()) {
+                if (has_error) {
+                    break;
+                }
+                for (const PreparedDocument& document : batch->documents) {
+                    search_server.AddPreparedDocument(document);
+                    ++document_count;
+                }
+            }
+        } catch (...) {
+            fail(current_exception());
+        }
+    });
+
+    try {
+        while (auto chunk = chunks.Pop()) {
+            if (has_error) {
+                break;
+            }
+            DocumentBatch batch;
+            batch.text = move(*chunk);
+            const string_view text(batch.text.data(), batch.text.size());
+            vector<string_view> records;
+            for (size_t begin = 0; begin < text.size();) {
+                const size_t end = min(text.find('\n', begin), text.size());
+                string_view record = text.substr(begin, end - begin);
+                if (!record.empty() && record.back() == '\r') {
+                    record.remove_suffix(1);
+                }
+                if (!record.empty()) {
+                    records.push_back(record);
+                }
+                begin = end + 1;
+            }
+            batch.documents.resize(records.size());
+            pool.ParallelFor(records.size(), [&](size_t i) {
+                batch.documents[i] = PrepareRecord(search_server, records[i]);
+            });
+            if (!batches.Push(move(batch))) {
+                break;
+            }
+        }
+    } catch (...) {
+        fail(current_exception());
+    }
+    batches.Close();
+
+    reader.join();
+    indexer.join();
+    if (first_error) {
+        rethrow_exception(first_error);
+    }
+    return document_count;
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include <istream>
+#include "search_server.h"
+#include "thread_pool.h"
+
+struct IngestionOptions {
+    size_t chunk_size = 1 << 20;
+    size_t queue_capacity = 4;
+};
+
+size_t IngestDocuments(SearchServer& search_server, std::istream& input, const IngestionOptions& options = {});
+
+size_t IngestDocuments(ThreadPool& pool, SearchServer& search_server, std::istream& input, const IngestionOptions& options = {});
@@ -0,0 +1,138 @@
+#include "forward_index.h"
+#include <algorithm>
+
+using namespace std;
+
+WordFrequenciesView::const_iterator::const_iterator(const TermDictionary* dictionary, const TermFrequency* position)
+    : dictionary_(dictionary)
+    , position_(position) {
+}
+
+WordFrequenciesView::const_iterator::value_type WordFrequenciesView::const_iterator::operator*() const {
+    return {dictionary_->GetTerm(position_->term_id), position_->term_freq};
+}
+
+WordFrequenciesView::const_iterator& WordFrequenciesView::const_iterator::operator++() {
+    ++position_;
+    return *this;
+}
+
+WordFrequenciesView::const_iterator WordFrequenciesView::const_iterator::operator++(int) {
+    const_iterator previous = *this;
+    ++position_;
+    return previous;
+}
+
+bool WordFrequenciesView::const_iterator::operator==(const const_iterator& other) const {
+    return position_ == other.position_;
+}
+
+bool WordFrequenciesView::const_iterator::operator!=(const const_iterator& other) const {
+    return position_ != other.position_;
+}
+
+WordFrequenciesView::WordFrequenciesView(const TermDictionary& dictionary, const TermFrequency* first, const TermFrequency* last)
+    : dictionary_(&dictionary)
+    , first_(first)
+    , last_(last) {
+}
+
+WordFrequenciesView::const_iterator WordFrequenciesView::begin() const {
+    return {dictionary_, first_};
+}
+
+WordFrequenciesView::const_iterator WordFrequenciesView::end() const {
+    return {dictionary_, last_};
+}
+
+size_t WordFrequenciesView::size() const {
+    return last_ - first_;
+}
+
+bool WordFrequenciesView::empty() const {
+    return first_ == last_;
+}
+
+const TermFrequency* WordFrequenciesView::data() const {
+    return first_;
+}
+
+ForwardIndex::ForwardIndex(pmr::memory_resource* resource) : document_to_slot_(resource) {
+}
+
+void ForwardIndex::AddDocument(int document_id, vector<TermFrequency> term_freqs) {
+    sort(term_freqs.begin(), term_freqs.end(), [](const TermFrequency& lhs, const TermFrequency& rhs) {
+        return lhs.term_id < rhs.term_id;
+    });
+    RemoveDocument(document_id);
+    document_to_slot_.emplace(document_id, slots_.size());
+    const size_t offset = entries_.size();
+    for (const TermFrequency& term_freq : term_freqs) {
+        if (entries_.size() > offset && entries_.back().term_id == term_freq.term_id) {
+            entries_.back().term_freq += term_freq.term_freq;
+        } else {
+            entries_.push_back(term_freq);
+        }
+    }
+    slots_.push_back({document_id, offset, entries_.size() - offset});
+}
+
+void ForwardIndex::RemoveDocument(int document_id) {
+    const auto it = document_to_slot_.find(document_id);
+    if (it == document_to_slot_.end()) {
+        return;
+    }
+    Slot& slot = slots_[it->second];
+    removed_entry_count_ += slot.size;
+    slot.document_id = -1;
+    document_to_slot_.erase(it);
+    if (removed_entry_count_ * 2 > entries_.size() || document_to_slot_.size() * 2 < slots_.size()) {
+        Compact();
+    }
+}
+
+pair<const TermFrequency*, const TermFrequency*> ForwardIndex::Find(int document_id) const {
+    const auto it = document_to_slot_.find(document_id);
+    if (it == document_to_slot_.end()) {
+        return {nullptr, nullptr};
+    }
+    const Slot& slot = slots_[it->second];
+    const TermFrequency* first = entries_.data() + slot.offset;
+    return {first, first + slot.size};
+}
+
+size_t ForwardIndex::GetEntryCount() const {
+    return entries_.size() - removed_entry_count_;
+}
+
+size_t ForwardIndex::GetRemovedEntryCount() const {
+    return removed_entry_count_;
+}
+
+MemoryUsage ForwardIndex::GetMemoryUsage() const {
+    MemoryUsage usage = EstimateTreeMemory(document_to_slot_.size(), sizeof(decltype(document_to_slot_)::value_type));
+    usage.used_bytes += GetEntryCount() * sizeof(TermFrequency) + document_to_slot_.size() * sizeof(Slot);
+    usage.allocated_bytes += entries_.capacity() * sizeof(TermFrequency) + slots_.capacity() * sizeof(Slot);
+    return usage;
+}
+
+void ForwardIndex::Compact() {
+    size_t entry_count = 0;
+    size_t slot_count = 0;
+    for (size_t i = 0; i < slots_.size(); ++i) {
+        const Slot slot = slots_[i];
+        if (slot.document_id < 0) {
+            continue;
+        }
+        if (slot.offset != entry_count) {
+            copy(entries_.begin() + slot.offset, entries_.begin() + slot.offset + slot.size, entries_.begin() + entry_count);
+        }
+        slots_[slot_count] = {slot.document_id, entry_count, slot.size};
+        document_to_slot_[slot.document_id] = slot_count;
+        entry_count += slot.size;
+        ++slot_count;
+    }
+    entries_.resize(entry_count);
+    slots_.resize(slot_count);
+    removed_entry_count_ = 0;
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include <cstddef>
+#include <iterator>
+#include <map>
+#include <memory_resource>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "index_stats.h"
+#include "term_dictionary.h"
+
+struct TermFrequency {
+    int term_id;
+    double term_freq;
+};
+
+class WordFrequenciesView {
+public:
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<std::string_view, double>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = value_type;
+
+        const_iterator() = default;
+        const_iterator(const TermDictionary* dictionary, const TermFrequency* position);
+
+        value_type operator*() const;
+
+        const_iterator& operator++();
+        const_iterator operator++(int);
+
+        bool operator==(const const_iterator& other) const;
+        bool operator!=(const const_iterator& other) const;
+    private:
+        const TermDictionary* dictionary_ = nullptr;
+        const TermFrequency* position_ = nullptr;
+    };
+
+    WordFrequenciesView() = default;
+    WordFrequenciesView(const TermDictionary& dictionary, const TermFrequency* first, const TermFrequency* last);
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    size_t size() const;
+    bool empty() const;
+
+    const TermFrequency* data() const;
+private:
+    const TermDictionary* dictionary_ = nullptr;
+    const TermFrequency* first_ = nullptr;
+    const TermFrequency* last_ = nullptr;
+};
+
+class ForwardIndex {
+public:
+    explicit ForwardIndex(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    void AddDocument(int document_id, std::vector<TermFrequency> term_freqs);
+
+    void RemoveDocument(int document_id);
+
+    std::pair<const TermFrequency*, const TermFrequency*> Find(int document_id) const;
+
+    size_t GetEntryCount() const;
+
+    size_t GetRemovedEntryCount() const;
+
+    MemoryUsage GetMemoryUsage() const;
+
+    template <typename Visitor>
+    void ForEachDocument(Visitor visitor) const;
+private:
+    struct Slot {
+        int document_id;
+        size_t offset;
+        size_t size;
+    };
+
+    std::vector<TermFrequency> entries_;
+    std::vector<Slot> slots_;
+    std::pmr::map<int, size_t> document_to_slot_;
+    size_t removed_entry_count_ = 0;
+
+    void Compact();
+};
+
+template <typename Visitor>
+void ForwardIndex::ForEachDocument(Visitor visitor) const {
+    for (const Slot& slot : slots_) {
+        if (slot.document_id >= 0) {
+            const TermFrequency* first = entries_.data() + slot.offset;
+            visitor(slot.document_id, first, first + slot.size);
+        }
+    }
+}
@@ -0,0 +1,107 @@
+#include "index_stats.h"
+#include <algorithm>
+
+using namespace std;
+
+size_t MemoryUsage::GetOverheadBytes() const {
+    return allocated_bytes - used_bytes;
+}
+
+MemoryUsage& MemoryUsage::operator+=(const MemoryUsage& other) {
+    used_bytes += other.used_bytes;
+    allocated_bytes += other.allocated_bytes;
+    return *this;
+}
+
+MemoryUsage IndexStats::GetTotalMemory() const {
+    MemoryUsage total;
+    total += word_to_document_freqs.memory;
+    total += document_to_word_freqs.memory;
+    total += documents.memory;
+    total += stop_words.memory;
+    total += term_dictionary.memory;
+    return total;
+}
+
+MemoryUsage EstimateTreeMemory(size_t node_count, size_t value_size) {
+    const size_t node_header_size = 4 * sizeof(void*);
+    MemoryUsage usage;
+    usage.used_bytes = node_count * value_size;
+    usage.allocated_bytes = node_count * (node_header_size + (value_size + alignof(max_align_t) - 1) / alignof(max_align_t) * alignof(max_align_t));
+    return usage;
+}
+
+void PostingStatsTracker::OnPostingCountChanged(int term_id, size_t old_count, size_t new_count) {
+    if (old_count == new_count) {
+        return;
+    }
+    total_postings_ += new_count;
+    total_postings_ -= old_count;
+    if (old_count == 0) {
+        ++vocabulary_size_;
+    } else {
+        --histogram_[GetHistogramBucket(old_count)];
+    }
+    if (new_count == 0) {
+        --vocabulary_size_;
+    } else {
+        const size_t bucket = GetHistogramBucket(new_count);
+        if (bucket >= histogram_.size()) {
+            histogram_.resize(bucket + 1);
+        }
+        ++histogram_[bucket];
+    }
+    UpdateHeaviestTerms(term_id, new_count);
+}
+
+size_t PostingStatsTracker::GetVocabularySize() const {
+    return vocabulary_size_;
+}
+
+size_t PostingStatsTracker::GetTotalPostings() const {
+    return total_postings_;
+}
+
+const vector<size_t>& PostingStatsTracker::GetHistogram() const {
+    return histogram_;
+}
+
+const vector<pair<int, size_t>>& PostingStatsTracker::GetHeaviestTerms() const {
+    return heaviest_terms_;
+}
+
+size_t PostingStatsTracker::GetHistogramBucket(size_t posting_count) {
+    size_t bucket = 0;
+    while (posting_count >>= 1) {
+        ++bucket;
+    }
+    return bucket;
+}
+
+void PostingStatsTracker::UpdateHeaviestTerms(int term_id, size_t posting_count) {
+    auto it = find_if(heaviest_terms_.begin(), heaviest_terms_.end(), [term_id](const pair<int, size_t>& term) {
+        return term.first == term_id;
+    });
+    if (it == heaviest_terms_.end()) {
+        if (posting_count == 0 || (heaviest_terms_.size() == HEAVIEST_TERM_COUNT && heaviest_terms_.back().second >= posting_count)) {
+            return;
+        }
+        if (heaviest_terms_.size() == HEAVIEST_TERM_COUNT) {
+            heaviest_terms_.pop_back();
+        }
+        heaviest_terms_.emplace_back(term_id, posting_count);
+        it = prev(heaviest_terms_.end());
+    } else if (posting_count == 0) {
+        heaviest_terms_.erase(it);
+        return;
+    }
+    it->second = posting_count;
+    while (it != heaviest_terms_.begin() && prev(it)->second < it->second) {
+        iter_swap(it, prev(it));
+        --it;
+    }
+    while (next(it) != heaviest_terms_.end() && next(it)->second > it->second) {
+        iter_swap(it, next(it));
+        ++it;
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstddef>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+struct MemoryUsage {
+    size_t used_bytes = 0;
+    size_t allocated_bytes = 0;
+
+    size_t GetOverheadBytes() const;
+
+    MemoryUsage& operator+=(const MemoryUsage& other);
+};
+
+struct StructureStats {
+    size_t entry_count = 0;
+    size_t removed_entry_count = 0;
+    MemoryUsage memory;
+};
+
+struct TermCost {
+    std::string_view term;
+    size_t posting_count = 0;
+    size_t scanned_bytes = 0;
+};
+
+struct IndexStats {
+    int document_count = 0;
+    size_t vocabulary_size = 0;
+    size_t total_postings = 0;
+    std::vector<size_t> posting_length_histogram;
+
+    StructureStats word_to_document_freqs;
+    StructureStats document_to_word_freqs;
+    StructureStats documents;
+    StructureStats stop_words;
+    StructureStats term_dictionary;
+
+    std::vector<TermCost> heaviest_terms;
+
+    MemoryUsage GetTotalMemory() const;
+};
+
+MemoryUsage EstimateTreeMemory(size_t node_count, size_t value_size);
+
+class PostingStatsTracker {
+public:
+    static const size_t HEAVIEST_TERM_COUNT = 16;
+
+    void OnPostingCountChanged(int term_id, size_t old_count, size_t new_count);
+
+    size_t GetVocabularySize() const;
+
+    size_t GetTotalPostings() const;
+
+    const std::vector<size_t>& GetHistogram() const;
+
+    const std::vector<std::pair<int, size_t>>& GetHeaviestTerms() const;
+private:
+    size_t vocabulary_size_ = 0;
+    size_t total_postings_ = 0;
+    std::vector<size_t> histogram_;
+    std::vector<std::pair<int, size_t>> heaviest_terms_;
+
+    static size_t GetHistogramBucket(size_t posting_count);
+
+    void UpdateHeaviestTerms(int term_id, size_t posting_count);
+};
@@ -1,11 +1,55 @@
+#include "document_ingestion.h"
 #include "search_server.h"
+#include "sharded_search_server.h"
 #include "log_duration.h"
+#include "paginator.h"
+#include "text_normalizer.h"
+#include "test_example_functions.h"
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <deque>
 #include <execution>
+#include <new>
 #include <iostream>
+#include <limits>
 #include <random>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 using namespace std;
+static atomic<size_t> allocation_count = 0;
+static atomic<size_t> allocated_bytes = 0;
+void* operator new(size_t size) {
+    allocation_count.fetch_add(1, memory_order_relaxed);
+    allocated_bytes.fetch_add(size, memory_order_relaxed);
+    if (void* pointer = malloc(size == 0 ? 1 : size)) {
+        return pointer;
+    }
+    throw bad_alloc();
+}
+void operator delete(void* pointer) noexcept {
+    free(pointer);
+}
+void operator delete(void* pointer, size_t) noexcept {
+    free(pointer);
+}
+class AllocationReport {
+public:
+    explicit AllocationReport(string_view mark)
+        : mark_(mark)
+        , count_(allocation_count.load())
+        , bytes_(allocated_bytes.load()) {
+    }
+    ~AllocationReport() {
+        cerr << mark_ << ": "s << allocation_count.load() - count_ << " allocations, "s << allocated_bytes.load() - bytes_ << " bytes"s << endl;
+    }
+private:
+    string_view mark_;
+    size_t count_;
+    size_t bytes_;
+};
 string GenerateWord(mt19937& generator, int max_length) {
     const int length = uniform_int_distribution<>(1, max_length)(generator);
     string word;
@@ -45,9 +89,10 @@ vector<string> GenerateQueries(mt19937& generator, const vector<string>& diction
     }
     return queries;
 }
-template <typename ExecutionPolicy>
-void Test(string_view mark, const SearchServer& search_server, const vector<string>& queries, ExecutionPolicy&& policy) {
+template <typename Server, typename ExecutionPolicy>
+void Test(string_view mark, const Server& search_server, const vector<string>& queries, ExecutionPolicy&& policy) {
     LOG_DURATION(mark);
+    AllocationReport allocation_report(mark);
     double total_relevance = 0;
     for (const string_view query : queries) {
         for (const auto& document : search_server.FindTopDocuments(policy, query)) {
@@ -58,14 +103,168 @@ void Test(string_view mark, const SearchServer& search_server, const vector<stri
 }
 #define TEST(policy) Test(#policy, search_server, queries, execution::policy)
 int main() {
+    TestSearchServer();
     mt19937 generator;
     const auto dictionary = GenerateDictionary(generator, 1000, 10);
     const auto documents = GenerateQueries(generator, dictionary, 10'000, 70);
     SearchServer search_server(dictionary[0]);
-    for (size_t i = 0; i < documents.size(); ++i) {
-        search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    {
+        LOG_DURATION("index"s);
+        AllocationReport allocation_report("index"sv);
+        for (size_t i = 0; i < documents.size(); ++i) {
+            search_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+        }
+    }
+    {
+        const IndexStats stats = search_server.GetIndexStats();
+        cerr << "index stats: "s << stats.vocabulary_size << " terms, "s << stats.total_postings << " postings, "s
+             << stats.GetTotalMemory().allocated_bytes << " bytes"s << endl;
+    }
+    {
+        string records;
+        for (size_t i = 0; i < documents.size(); ++i) {
+            records += to_string(i) + "\tACTUAL\t1 2 3\t"s + documents[i] + '\n';
+        }
+        istringstream input(records);
+        SearchServer ingested_server(dictionary[0]);
+        LOG_DURATION("ingest"s);
+        AllocationReport allocation_report("ingest"sv);
+        IngestDocuments(ingested_server, input);
+    }
+    {
+        LOG_DURATION("forward scan"s);
+        AllocationReport allocation_report("forward scan"sv);
+        double total_term_freq = 0;
+        search_server.ForEachDocument([&](int, const WordFrequenciesView word_freqs) {
+            for (const auto [word, term_freq] : word_freqs) {
+                total_term_freq += term_freq;
+            }
+        });
+        cout << total_term_freq << endl;
+    }
+    {
+        const TextNormalizer normalizer(NormalizationOptions{true, true, true});
+        vector<string> mixed_case_documents = documents;
+        for (string& document : mixed_case_documents) {
+            for (size_t i = 0; i < document.size(); ++i) {
+                if (i == 0 || document[i - 1] == ' ') {
+                    document[i] = toupper(document[i]);
+                }
+            }
+        }
+        size_t split_count = 0;
+        {
+            LOG_DURATION("split words"s);
+            for (const string& document : documents) {
+                split_count += SplitIntoWords(document).size();
+            }
+        }
+        const auto normalize = [&normalizer](string_view mark, const vector<string>& texts) {
+            LOG_DURATION(mark);
+            AllocationReport allocation_report(mark);
+            size_t token_count = 0;
+            deque<string> normalized_words;
+            vector<string_view> tokens;
+            for (const string& text : texts) {
+                tokens.clear();
+                normalizer.Tokenize(text, normalized_words, tokens);
+                token_count += tokens.size();
+            }
+            return token_count;
+        };
+        const size_t normalized_count = normalize("normalize words"sv, documents);
+        const size_t mixed_case_count = normalize("normalize mixed case"sv, mixed_case_documents);
+        cout << split_count << ' ' << normalized_count << ' ' << mixed_case_count << endl;
     }
     const auto queries = GenerateQueries(generator, dictionary, 100, 70);
     TEST(seq);
     TEST(par);
+    {
+        const auto thresholds = search_server.CalibrateQueryPlanner(vector<string>(queries.begin(), queries.begin() + 20));
+        if (thresholds.parallel_posting_count == numeric_limits<size_t>::max()) {
+            cerr << "planner: always sequential"s;
+        } else {
+            cerr << "planner: parallel from "s << thresholds.parallel_posting_count << " postings"s;
+        }
+        cerr << ", candidate cost "s << thresholds.candidate_cost << endl;
+        LOG_DURATION("auto"s);
+        double total_relevance = 0;
+        for (const string_view query : queries) {
+            QueryStats stats;
+            for (const auto& document : search_server.FindTopDocuments(query, DocumentFilter{{DocumentStatus::ACTUAL}}, stats)) {
+                total_relevance += document.relevance;
+            }
+        }
+        cout << total_relevance << endl;
+    }
+
+    {
+        LOG_DURATION("deep pages"s);
+        size_t page_count = 0;
+        size_t document_count = 0;
+        for (size_t i = 0; i < 10; ++i) {
+            for (const auto page : PaginateResults(search_server, queries[i], 100)) {
+                document_count += page.size();
+                if (++page_count % 5 == 0) {
+                    break;
+                }
+            }
+        }
+        cout << page_count << ' ' << document_count << endl;
+    }
+    {
+        LOG_DURATION("batch"s);
+        AllocationReport allocation_report("batch"sv);
+        double total_relevance = 0;
+        for (const auto& top_documents : search_server.FindTopDocumentsBatch(queries, DocumentStatus::ACTUAL)) {
+            for (const auto& document : top_documents) {
+                total_relevance += document.relevance;
+            }
+        }
+        cout << total_relevance << endl;
+    }
+
+    ThreadPool pool(max(1u, thread::hardware_concurrency()), CpuAffinity::NUMA_NODES);
+    Test("pool"sv, search_server, queries, pool);
+
+    ShardedSearchServer sharded_server(dictionary[0], 4);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        sharded_server.AddDocument(i, documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+    }
+    Test("sharded seq"sv, sharded_server, queries, execution::seq);
+    Test("sharded par"sv, sharded_server, queries, execution::par);
+
+    const auto standing_queries = GenerateQueries(generator, dictionary, 1000, 3);
+    vector<int> subscription_ids;
+    for (const string& query : standing_queries) {
+        subscription_ids.push_back(search_server.AddSubscription(query, DocumentStatus::ACTUAL));
+    }
+    const auto new_documents = GenerateQueries(generator, dictionary, 1000, 70);
+    {
+        LOG_DURATION("standing queries"s);
+        for (size_t i = 0; i < new_documents.size(); ++i) {
+            search_server.AddDocument(documents.size() + i, new_documents[i], DocumentStatus::ACTUAL, {1, 2, 3});
+        }
+        cout << search_server.TakeUpdatedSubscriptions().size() << endl;
+    }
+    {
+        LOG_DURATION("standing queries rescan"s);
+        double total_relevance = 0;
+        for (const string_view query : standing_queries) {
+            for (const auto& document : search_server.FindTopDocuments(execution::seq, query)) {
+                total_relevance += document.relevance;
+            }
+        }
+        cout << total_relevance << endl;
+    }
+    {
+        LOG_DURATION("standing queries read"s);
+        double total_relevance = 0;
+        for (const int subscription_id : subscription_ids) {
+            for (const auto& document : search_server.GetSubscriptionTopDocuments(subscription_id)) {
+                total_relevance += document.relevance;
+            }
+        }
+        cout << total_relevance << endl;
+    }
 }
\ No newline at end of file
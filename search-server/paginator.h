@@ -3,6 +3,10 @@
 #include <algorithm>
 #include <iterator>
 #include <cassert>
+#include <optional>
+#include <string_view>
+#include <vector>
+#include "document.h"
 
 template <typename Iterator>
 class IteratorRange {
@@ -72,4 +76,78 @@ private:
 template <typename Container>
 auto Paginate(const Container& c, size_t page_size) {
     return Paginator(begin(c), end(c), page_size);
-}
\ No newline at end of file
+}
+
+template <typename PageSource>
+class LazyPaginator {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = IteratorRange<std::vector<Document>::const_iterator>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = value_type;
+
+        iterator() = default;
+
+        explicit iterator(const PageSource* source)
+                : source_(source)
+                , page_((*source)(std::nullopt)) {
+            if (page_.documents.empty()) {
+                source_ = nullptr;
+            }
+        }
+
+        value_type operator*() const {
+            return {page_.documents.begin(), page_.documents.end()};
+        }
+
+        iterator& operator++() {
+            if (page_.next_cursor) {
+                page_ = (*source_)(page_.next_cursor);
+            } else {
+                page_ = {};
+            }
+            if (page_.documents.empty()) {
+                source_ = nullptr;
+            }
+            return *this;
+        }
+
+        bool operator==(const iterator& other) const {
+            return source_ == other.source_;
+        }
+
+        bool operator!=(const iterator& other) const {
+            return source_ != other.source_;
+        }
+
+    private:
+        const PageSource* source_ = nullptr;
+        DocumentPage page_;
+    };
+
+    explicit LazyPaginator(PageSource source)
+            : source_(std::move(source)) {
+    }
+
+    iterator begin() const {
+        return iterator(&source_);
+    }
+
+    iterator end() const {
+        return {};
+    }
+
+private:
+    PageSource source_;
+};
+
+template <typename Server>
+auto PaginateResults(const Server& server, std::string_view raw_query, size_t page_size) {
+    return LazyPaginator([&server, raw_query, page_size](const std::optional<PageCursor>& after) {
+        return after ? server.FindTopDocumentsPage(raw_query, *after, page_size)
+                     : server.FindTopDocumentsPage(raw_query, 0, page_size);
+    });
+}
@@ -0,0 +1,128 @@
+#include "positional_index.h"
+#include <algorithm>
+
+using namespace std;
+
+namespace {
+
+void AppendVarint(vector<uint8_t>& data, uint32_t value) {
+    while (value >= 0x80) {
+        data.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    data.push_back(static_cast<uint8_t>(value));
+}
+
+uint32_t ReadVarint(const vector<uint8_t>& data, uint32_t& offset) {
+    uint32_t value = 0;
+    for (int shift = 0; ; shift += 7) {
+        const uint8_t byte = data[offset++];
+        value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+}
+
+}
+
+vector<uint8_t> EncodePositions(const vector<int>& positions) {
+    vector<uint8_t> data;
+    AppendVarint(data, positions.size());
+    int previous = 0;
+    for (const int position : positions) {
+        AppendVarint(data, position - previous);
+        previous = position;
+    }
+    return data;
+}
+
+vector<int> DecodePositions(const vector<uint8_t>& data, uint32_t offset) {
+    vector<int> positions(ReadVarint(data, offset));
+    int previous = 0;
+    for (int& position : positions) {
+        position = previous + static_cast<int>(ReadVarint(data, offset));
+        previous = position;
+    }
+    return positions;
+}
+
+void PositionalIndex::AddDocument(int document_id, const vector<int>& term_ids) {
+    map<int, vector<int>> term_to_positions;
+    for (size_t i = 0; i < term_ids.size(); ++i) {
+        term_to_positions[term_ids[i]].push_back(i);
+    }
+
+    DocumentPositions& document_positions = document_to_positions_[document_id];
+    document_positions.term_offsets.reserve(term_to_positions.size());
+    for (const auto& [term_id, positions] : term_to_positions) {
+        document_positions.term_offsets.emplace_back(term_id, document_positions.data.size());
+        const auto encoded = EncodePositions(positions);
+        document_positions.data.insert(document_positions.data.end(), encoded.begin(), encoded.end());
+    }
+    document_positions.data.shrink_to_fit();
+}
+
+void PositionalIndex::RemoveDocument(int document_id) {
+    document_to_positions_.erase(document_id);
+}
+
+bool PositionalIndex::FindPositions(const DocumentPositions& positions, int term_id, vector<int>& result) {
+    const auto it = lower_bound(positions.term_offsets.begin(), positions.term_offsets.end(), term_id,
+                                [](const auto& entry, int value) {
+                                    return entry.first < value;
+                                });
+    if (it == positions.term_offsets.end() || it->first != term_id) {
+        return false;
+    }
+    result = DecodePositions(positions.data, it->second);
+    return true;
+}
+
+bool PositionalIndex::ContainsPhrase(int document_id, const vector<int>& phrase, int slop) const {
+    return FindPhraseSpan(document_id, phrase, slop, static_cast<int>(phrase.size()) - 1 + slop) >= 0;
+}
+
+int PositionalIndex::FindShortestPhraseSpan(int document_id, const vector<int>& phrase, int slop) const {
+    return FindPhraseSpan(document_id, phrase, slop, static_cast<int>(phrase.size()) - 1);
+}
+
+int PositionalIndex::FindPhraseSpan(int document_id, const vector<int>& phrase, int slop, int sufficient_span) const {
+    const auto document_it = document_to_positions_.find(document_id);
+    if (document_it == document_to_positions_.end() || phrase.empty()) {
+        return -1;
+    }
+
+    vector<vector<int>> word_positions(phrase.size());
+    for (size_t i = 0; i < phrase.size(); ++i) {
+        if (!FindPositions(document_it->second, phrase[i], word_positions[i])) {
+            return -1;
+        }
+    }
+
+    const int max_span = static_cast<int>(phrase.size()) - 1 + slop;
+    int shortest_span = -1;
+    vector<size_t> cursors(phrase.size(), 0);
+    for (const int first_position : word_positions[0]) {
+        int previous = first_position;
+        for (size_t i = 1; i < phrase.size(); ++i) {
+            const auto& positions = word_positions[i];
+            size_t& cursor = cursors[i];
+            while (cursor < positions.size() && positions[cursor] <= previous) {
+                ++cursor;
+            }
+            if (cursor == positions.size()) {
+                return shortest_span;
+            }
+            previous = positions[cursor];
+        }
+        const int span = previous - first_position;
+        if (span <= max_span && (shortest_span < 0 || span < shortest_span)) {
+            shortest_span = span;
+        }
+        if (shortest_span >= 0 && shortest_span <= sufficient_span) {
+            return shortest_span;
+        }
+    }
+    return shortest_span;
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+std::vector<uint8_t> EncodePositions(const std::vector<int>& positions);
+std::vector<int> DecodePositions(const std::vector<uint8_t>& data, uint32_t offset);
+
+class PositionalIndex {
+public:
+    void AddDocument(int document_id, const std::vector<int>& term_ids);
+
+    void RemoveDocument(int document_id);
+
+    bool ContainsPhrase(int document_id, const std::vector<int>& phrase, int slop) const;
+
+    int FindShortestPhraseSpan(int document_id, const std::vector<int>& phrase, int slop) const;
+
+private:
+    struct DocumentPositions {
+        std::vector<std::pair<int, uint32_t>> term_offsets;
+        std::vector<uint8_t> data;
+    };
+
+    std::map<int, DocumentPositions> document_to_positions_;
+
+    int FindPhraseSpan(int document_id, const std::vector<int>& phrase, int slop, int sufficient_span) const;
+
+    static bool FindPositions(const DocumentPositions& positions, int term_id, std::vector<int>& result);
+};
@@ -0,0 +1,59 @@
+#include "posting_list.h"
+#include <algorithm>
+
+using namespace std;
+
+PostingList::PostingList(pmr::memory_resource* resource) : document_ids_(resource), term_freqs_(resource) {
+}
+
+void PostingList::Add(int document_id, double term_freq) {
+    if (document_ids_.empty() || document_ids_.back() < document_id) {
+        document_ids_.push_back(document_id);
+        term_freqs_.push_back(term_freq);
+        return;
+    }
+    const auto it = lower_bound(document_ids_.begin(), document_ids_.end(), document_id);
+    const auto index = distance(document_ids_.begin(), it);
+    if (*it == document_id) {
+        term_freqs_[index] += term_freq;
+        return;
+    }
+    document_ids_.insert(it, document_id);
+    term_freqs_.insert(term_freqs_.begin() + index, term_freq);
+}
+
+void PostingList::Remove(int document_id) {
+    const auto it = lower_bound(document_ids_.begin(), document_ids_.end(), document_id);
+    if (it == document_ids_.end() || *it != document_id) {
+        return;
+    }
+    term_freqs_.erase(term_freqs_.begin() + distance(document_ids_.begin(), it));
+    document_ids_.erase(it);
+}
+
+bool PostingList::Contains(int document_id) const {
+    return binary_search(document_ids_.begin(), document_ids_.end(), document_id);
+}
+
+size_t PostingList::size() const {
+    return document_ids_.size();
+}
+
+bool PostingList::empty() const {
+    return document_ids_.empty();
+}
+
+const pmr::vector<int>& PostingList::GetDocumentIds() const {
+    return document_ids_;
+}
+
+const pmr::vector<double>& PostingList::GetTermFreqs() const {
+    return term_freqs_;
+}
+
+MemoryUsage PostingList::GetMemoryUsage() const {
+    MemoryUsage usage;
+    usage.used_bytes = document_ids_.size() * sizeof(int) + term_freqs_.size() * sizeof(double);
+    usage.allocated_bytes = sizeof(PostingList) + document_ids_.capacity() * sizeof(int) + term_freqs_.capacity() * sizeof(double);
+    return usage;
+}
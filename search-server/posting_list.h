@@ -0,0 +1,101 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory_resource>
+#include <vector>
+#include "index_stats.h"
+
+class PostingList {
+public:
+    explicit PostingList(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    void Add(int document_id, double term_freq);
+
+    void Remove(int document_id);
+
+    bool Contains(int document_id) const;
+
+    size_t size() const;
+
+    bool empty() const;
+
+    const std::pmr::vector<int>& GetDocumentIds() const;
+
+    const std::pmr::vector<double>& GetTermFreqs() const;
+
+    MemoryUsage GetMemoryUsage() const;
+private:
+    std::pmr::vector<int> document_ids_;
+    std::pmr::vector<double> term_freqs_;
+};
+
+template <typename SortedIds>
+size_t GallopLowerBound(const SortedIds& values, size_t from, int target);
+
+template <typename Lhs, typename Rhs>
+std::vector<int> IntersectSorted(const Lhs& lhs, const Rhs& rhs);
+
+template <typename Lhs, typename Rhs>
+std::vector<int> UniteSorted(const Lhs& lhs, const Rhs& rhs);
+
+template <typename SortedIds, typename ExcludedIds>
+std::vector<int> SubtractSorted(const SortedIds& values, const ExcludedIds& excluded);
+
+template <typename SortedIds>
+size_t GallopLowerBound(const SortedIds& values, size_t from, int target) {
+    if (from >= values.size() || values[from] >= target) {
+        return from;
+    }
+    size_t step = 1;
+    size_t low = from;
+    size_t high = from + step;
+    while (high < values.size() && values[high] < target) {
+        low = high;
+        step *= 2;
+        high = from + step;
+    }
+    high = std::min(high, values.size());
+    return std::distance(values.begin(), std::lower_bound(values.begin() + low + 1, values.begin() + high, target));
+}
+
+template <typename Lhs, typename Rhs>
+std::vector<int> IntersectSorted(const Lhs& lhs, const Rhs& rhs) {
+    if (lhs.size() > rhs.size()) {
+        return IntersectSorted(rhs, lhs);
+    }
+    std::vector<int> result;
+    size_t cursor = 0;
+    for (const int value : lhs) {
+        cursor = GallopLowerBound(rhs, cursor, value);
+        if (cursor == rhs.size()) {
+            break;
+        }
+        if (rhs[cursor] == value) {
+            result.push_back(value);
+        }
+    }
+    return result;
+}
+
+template <typename Lhs, typename Rhs>
+std::vector<int> UniteSorted(const Lhs& lhs, const Rhs& rhs) {
+    std::vector<int> result;
+    result.reserve(lhs.size() + rhs.size());
+    std::set_union(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), std::back_inserter(result));
+    return result;
+}
+
+template <typename SortedIds, typename ExcludedIds>
+std::vector<int> SubtractSorted(const SortedIds& values, const ExcludedIds& excluded) {
+    std::vector<int> result;
+    result.reserve(values.size());
+    size_t cursor = 0;
+    for (const int value : values) {
+        cursor = GallopLowerBound(excluded, cursor, value);
+        if (cursor == excluded.size() || excluded[cursor] != value) {
+            result.push_back(value);
+        }
+    }
+    return result;
+}
@@ -10,9 +10,16 @@ using namespace std;
 std::vector<std::vector<Document>> ProcessQueries(
         const SearchServer& search_server,
         const std::vector<std::string> queries) {
+    return ProcessQueries(ThreadPool::GetDefault(), search_server, queries);
+}
+
+std::vector<std::vector<Document>> ProcessQueries(
+        ThreadPool& pool,
+        const SearchServer& search_server,
+        const std::vector<std::string> queries) {
     vector<vector<Document>> answer(queries.size());
-    transform(execution::par, queries.begin(), queries.end(), answer.begin(), [&search_server](string query){
-        return search_server.FindTopDocuments(query);
+    pool.ParallelFor(queries.size(), [&](size_t i) {
+        answer[i] = search_server.FindTopDocuments(queries[i]);
     });
     return answer;
 }
@@ -20,7 +27,14 @@ std::vector<std::vector<Document>> ProcessQueries(
 list<Document> ProcessQueriesJoined(
         const SearchServer& search_server,
         const std::vector<std::string> queries) {
-    auto documents = ProcessQueries(search_server, queries);
+    return ProcessQueriesJoined(ThreadPool::GetDefault(), search_server, queries);
+}
+
+list<Document> ProcessQueriesJoined(
+        ThreadPool& pool,
+        const SearchServer& search_server,
+        const std::vector<std::string> queries) {
+    auto documents = ProcessQueries(pool, search_server, queries);
     list<Document> answer;
     for (const auto& docs : documents) {
         for (const auto & doc : docs) {
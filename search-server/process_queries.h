@@ -2,13 +2,24 @@
 
 #include "document.h"
 #include "search_server.h"
+#include "thread_pool.h"
 #include <list>
 
 std::vector<std::vector<Document>> ProcessQueries(
         const SearchServer& search_server,
         const std::vector<std::string> queries);
 
+std::vector<std::vector<Document>> ProcessQueries(
+        ThreadPool& pool,
+        const SearchServer& search_server,
+        const std::vector<std::string> queries);
+
+std::list<Document> ProcessQueriesJoined(
+        const SearchServer& search_server,
+        const std::vector<std::string> queries);
+
 std::list<Document> ProcessQueriesJoined(
+        ThreadPool& pool,
         const SearchServer& search_server,
         const std::vector<std::string> queries);
 
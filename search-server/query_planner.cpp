@@ -0,0 +1,52 @@
+#include "query_planner.h"
+#include <algorithm>
+#include <limits>
+
+using namespace std;
+
+QueryPlanner::QueryPlanner(const QueryPlannerThresholds& thresholds) : thresholds_(thresholds) {
+}
+
+const QueryPlannerThresholds& QueryPlanner::GetThresholds() const {
+    return thresholds_;
+}
+
+void QueryPlanner::Plan(QueryStats& stats, bool has_candidates, size_t thread_count) const {
+    const double candidate_cost = static_cast<double>(stats.candidate_count) * stats.term_count * thresholds_.candidate_cost;
+    if (has_candidates && candidate_cost < stats.posting_count) {
+        stats.strategy = EvaluationStrategy::DOCUMENT_AT_A_TIME;
+        stats.mode = ExecutionMode::SEQUENTIAL;
+        return;
+    }
+    stats.strategy = EvaluationStrategy::TERM_AT_A_TIME;
+    stats.mode = thread_count > 1 && stats.posting_count >= thresholds_.parallel_posting_count
+                 ? ExecutionMode::PARALLEL : ExecutionMode::SEQUENTIAL;
+}
+
+ExecutionMode QueryPlanner::PlanMatch(size_t term_count, size_t thread_count) const {
+    return thread_count > 1 && term_count >= thresholds_.parallel_match_term_count
+           ? ExecutionMode::PARALLEL : ExecutionMode::SEQUENTIAL;
+}
+
+size_t QueryPlanner::FitParallelThreshold(vector<ExecutionSample> samples) {
+    sort(samples.begin(), samples.end(), [](const ExecutionSample& lhs, const ExecutionSample& rhs) {
+        return lhs.cost > rhs.cost;
+    });
+    double total_time = 0.0;
+    for (const ExecutionSample& sample : samples) {
+        total_time += sample.sequential_time;
+    }
+    size_t best_threshold = numeric_limits<size_t>::max();
+    double best_time = total_time;
+    for (size_t i = 0; i < samples.size(); ++i) {
+        total_time += samples[i].parallel_time - samples[i].sequential_time;
+        if (i + 1 < samples.size() && samples[i + 1].cost == samples[i].cost) {
+            continue;
+        }
+        if (total_time < best_time) {
+            best_time = total_time;
+            best_threshold = samples[i].cost;
+        }
+    }
+    return best_threshold;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+enum class ExecutionMode {
+    SEQUENTIAL,
+    PARALLEL,
+};
+
+enum class EvaluationStrategy {
+    TERM_AT_A_TIME,
+    DOCUMENT_AT_A_TIME,
+};
+
+struct QueryStats {
+    size_t term_count = 0;
+    size_t posting_count = 0;
+    size_t excluded_count = 0;
+    size_t candidate_count = 0;
+    ExecutionMode mode = ExecutionMode::SEQUENTIAL;
+    EvaluationStrategy strategy = EvaluationStrategy::TERM_AT_A_TIME;
+};
+
+struct QueryPlannerThresholds {
+    size_t parallel_posting_count = 1 << 16;
+    size_t parallel_match_term_count = 1 << 12;
+    double candidate_cost = 0.25;
+};
+
+struct ExecutionSample {
+    size_t cost = 0;
+    double sequential_time = 0.0;
+    double parallel_time = 0.0;
+};
+
+class QueryPlanner {
+public:
+    QueryPlanner() = default;
+
+    explicit QueryPlanner(const QueryPlannerThresholds& thresholds);
+
+    const QueryPlannerThresholds& GetThresholds() const;
+
+    void Plan(QueryStats& stats, bool has_candidates, size_t thread_count) const;
+
+    ExecutionMode PlanMatch(size_t term_count, size_t thread_count) const;
+
+    static size_t FitParallelThreshold(std::vector<ExecutionSample> samples);
+private:
+    QueryPlannerThresholds thresholds_;
+};
@@ -4,17 +4,16 @@ using namespace std;
 
 void RemoveDuplicates(SearchServer& search_server) {
     vector<int> id_to_delete;
-    map<set<string_view>, int> complect_words;
+    set<vector<string_view>> complect_words;
     for (int document_id : search_server) {
-        const auto word_freq = search_server.GetWordFrequencies(document_id);
-        set<string_view> words;
-        for (const auto [word, freq] : word_freq) {
-            words.insert(word);
+        const WordFrequenciesView word_freq = search_server.GetWordFrequencies(document_id);
+        vector<string_view> words;
+        words.reserve(word_freq.size());
+        for (const auto [word, term_freq] : word_freq) {
+            words.push_back(word);
         }
-        if (complect_words.count(words) > 0) {
+        if (!complect_words.insert(move(words)).second) {
             id_to_delete.push_back(document_id);
-        } else {
-            complect_words[words]++;
         }
     }
     for (auto id : id_to_delete) {
@@ -0,0 +1,514 @@
+#include "roaring_bitmap.h"
+#include <algorithm>
+
+using namespace std;
+
+RoaringBitmap::const_iterator::const_iterator(const RoaringBitmap* bitmap, size_t container_index)
+    : bitmap_(bitmap)
+    , container_index_(container_index) {
+    SkipEmpty();
+}
+
+int RoaringBitmap::const_iterator::operator*() const {
+    const Container& container = bitmap_->containers_[container_index_];
+    uint32_t low = 0;
+    switch (container.type) {
+        case ContainerType::ARRAY:
+            low = container.values[position_];
+            break;
+        case ContainerType::BITMAP:
+            low = position_;
+            break;
+        case ContainerType::RUN:
+            low = container.values[2 * position_] + run_offset_;
+            break;
+    }
+    return static_cast<int>(static_cast<uint32_t>(bitmap_->keys_[container_index_]) << 16 | low);
+}
+
+RoaringBitmap::const_iterator& RoaringBitmap::const_iterator::operator++() {
+    const Container& container = bitmap_->containers_[container_index_];
+    switch (container.type) {
+        case ContainerType::ARRAY:
+            ++position_;
+            break;
+        case ContainerType::BITMAP:
+            ++position_;
+            break;
+        case ContainerType::RUN:
+            if (run_offset_ < container.values[2 * position_ + 1]) {
+                ++run_offset_;
+            } else {
+                ++position_;
+                run_offset_ = 0;
+            }
+            break;
+    }
+    SkipEmpty();
+    return *this;
+}
+
+RoaringBitmap::const_iterator RoaringBitmap::const_iterator::operator++(int) {
+    const_iterator previous = *this;
+    ++*this;
+    return previous;
+}
+
+bool RoaringBitmap::const_iterator::operator==(const const_iterator& other) const {
+    return container_index_ == other.container_index_ && position_ == other.position_ && run_offset_ == other.run_offset_;
+}
+
+bool RoaringBitmap::const_iterator::operator!=(const const_iterator& other) const {
+    return !(*this == other);
+}
+
+void RoaringBitmap::const_iterator::SkipEmpty() {
+    while (container_index_ < bitmap_->containers_.size()) {
+        const Container& container = bitmap_->containers_[container_index_];
+        if (container.type == ContainerType::BITMAP) {
+            while (position_ < BITMAP_WORDS * 64) {
+                const uint64_t word = container.bits[position_ / 64] >> (position_ % 64);
+                if (word != 0) {
+                    position_ += __builtin_ctzll(word);
+                    return;
+                }
+                position_ = (position_ / 64 + 1) * 64;
+            }
+        } else {
+            const uint32_t size = container.type == ContainerType::ARRAY ? container.values.size() : container.values.size() / 2;
+            if (position_ < size) {
+                return;
+            }
+        }
+        ++container_index_;
+        position_ = 0;
+        run_offset_ = 0;
+    }
+    position_ = 0;
+    run_offset_ = 0;
+}
+
+void RoaringBitmap::Add(int value) {
+    const uint16_t key = static_cast<uint32_t>(value) >> 16;
+    const uint16_t low = static_cast<uint32_t>(value) & 0xFFFF;
+    if (keys_.empty() || keys_.back() < key) {
+        keys_.push_back(key);
+        containers_.emplace_back();
+        ContainerAdd(containers_.back(), low);
+        return;
+    }
+    const auto it = lower_bound(keys_.begin(), keys_.end(), key);
+    const auto index = distance(keys_.begin(), it);
+    if (*it != key) {
+        keys_.insert(it, key);
+        containers_.insert(containers_.begin() + index, Container{});
+    }
+    ContainerAdd(containers_[index], low);
+}
+
+void RoaringBitmap::Remove(int value) {
+    const uint16_t key = static_cast<uint32_t>(value) >> 16;
+    const auto it = lower_bound(keys_.begin(), keys_.end(), key);
+    if (it == keys_.end() || *it != key) {
+        return;
+    }
+    const auto index = distance(keys_.begin(), it);
+    ContainerRemove(containers_[index], static_cast<uint32_t>(value) & 0xFFFF);
+    if (containers_[index].cardinality == 0) {
+        keys_.erase(it);
+        containers_.erase(containers_.begin() + index);
+    }
+}
+
+bool RoaringBitmap::Contains(int value) const {
+    const Container* container = FindContainer(static_cast<uint32_t>(value) >> 16);
+    return container != nullptr && ContainerContains(*container, static_cast<uint32_t>(value) & 0xFFFF);
+}
+
+size_t RoaringBitmap::Count() const {
+    size_t count = 0;
+    for (const Container& container : containers_) {
+        count += container.cardinality;
+    }
+    return count;
+}
+
+bool RoaringBitmap::empty() const {
+    return containers_.empty();
+}
+
+RoaringBitmap::const_iterator RoaringBitmap::begin() const {
+    return const_iterator(this, 0);
+}
+
+RoaringBitmap::const_iterator RoaringBitmap::end() const {
+    return const_iterator(this, containers_.size());
+}
+
+vector<int> RoaringBitmap::ToVector() const {
+    vector<int> result;
+    result.reserve(Count());
+    for (const int value : *this) {
+        result.push_back(value);
+    }
+    return result;
+}
+
+RoaringBitmap& RoaringBitmap::operator&=(const RoaringBitmap& other) {
+    vector<uint16_t> keys;
+    vector<Container> containers;
+    size_t i = 0;
+    size_t j = 0;
+    while (i < keys_.size() && j < other.keys_.size()) {
+        if (keys_[i] < other.keys_[j]) {
+            ++i;
+        } else if (other.keys_[j] < keys_[i]) {
+            ++j;
+        } else {
+            Container container = And(containers_[i], other.containers_[j]);
+            if (container.cardinality > 0) {
+                keys.push_back(keys_[i]);
+                containers.push_back(move(container));
+            }
+            ++i;
+            ++j;
+        }
+    }
+    keys_ = move(keys);
+    containers_ = move(containers);
+    return *this;
+}
+
+RoaringBitmap& RoaringBitmap::operator|=(const RoaringBitmap& other) {
+    vector<uint16_t> keys;
+    vector<Container> containers;
+    size_t i = 0;
+    size_t j = 0;
+    while (i < keys_.size() || j < other.keys_.size()) {
+        if (j == other.keys_.size() || (i < keys_.size() && keys_[i] < other.keys_[j])) {
+            keys.push_back(keys_[i]);
+            containers.push_back(move(containers_[i]));
+            ++i;
+        } else if (i == keys_.size() || other.keys_[j] < keys_[i]) {
+            keys.push_back(other.keys_[j]);
+            containers.push_back(other.containers_[j]);
+            ++j;
+        } else {
+            keys.push_back(keys_[i]);
+            containers.push_back(Or(containers_[i], other.containers_[j]));
+            ++i;
+            ++j;
+        }
+    }
+    keys_ = move(keys);
+    containers_ = move(containers);
+    return *this;
+}
+
+RoaringBitmap& RoaringBitmap::operator-=(const RoaringBitmap& other) {
+    vector<uint16_t> keys;
+    vector<Container> containers;
+    size_t j = 0;
+    for (size_t i = 0; i < keys_.size(); ++i) {
+        while (j < other.keys_.size() && other.keys_[j] < keys_[i]) {
+            ++j;
+        }
+        if (j < other.keys_.size() && other.keys_[j] == keys_[i]) {
+            Container container = AndNot(containers_[i], other.containers_[j]);
+            if (container.cardinality > 0) {
+                keys.push_back(keys_[i]);
+                containers.push_back(move(container));
+            }
+        } else {
+            keys.push_back(keys_[i]);
+            containers.push_back(move(containers_[i]));
+        }
+    }
+    keys_ = move(keys);
+    containers_ = move(containers);
+    return *this;
+}
+
+RoaringBitmap::Container* RoaringBitmap::FindContainer(uint16_t key) {
+    const auto it = lower_bound(keys_.begin(), keys_.end(), key);
+    if (it == keys_.end() || *it != key) {
+        return nullptr;
+    }
+    return &containers_[distance(keys_.begin(), it)];
+}
+
+const RoaringBitmap::Container* RoaringBitmap::FindContainer(uint16_t key) const {
+    const auto it = lower_bound(keys_.begin(), keys_.end(), key);
+    if (it == keys_.end() || *it != key) {
+        return nullptr;
+    }
+    return &containers_[distance(keys_.begin(), it)];
+}
+
+bool RoaringBitmap::ContainerContains(const Container& container, uint16_t value) {
+    switch (container.type) {
+        case ContainerType::ARRAY:
+            return binary_search(container.values.begin(), container.values.end(), value);
+        case ContainerType::BITMAP:
+            return (container.bits[value / 64] >> (value % 64) & 1) != 0;
+        case ContainerType::RUN: {
+            size_t low = 0;
+            size_t high = container.values.size() / 2;
+            while (low < high) {
+                const size_t middle = (low + high) / 2;
+                if (container.values[2 * middle] <= value) {
+                    low = middle + 1;
+                } else {
+                    high = middle;
+                }
+            }
+            if (low == 0) {
+                return false;
+            }
+            const uint32_t start = container.values[2 * (low - 1)];
+            return value <= start + container.values[2 * (low - 1) + 1];
+        }
+    }
+    return false;
+}
+
+void RoaringBitmap::ContainerAdd(Container& container, uint16_t value) {
+    if (container.type == ContainerType::RUN) {
+        if (AppendToRuns(container, value) || ContainerContains(container, value)) {
+            return;
+        }
+        Unpack(container);
+    }
+    if (container.type == ContainerType::BITMAP) {
+        uint64_t& word = container.bits[value / 64];
+        const uint64_t bit = uint64_t{1} << (value % 64);
+        if ((word & bit) == 0) {
+            word |= bit;
+            ++container.cardinality;
+        }
+        return;
+    }
+    auto& values = container.values;
+    if (values.empty() || values.back() < value) {
+        values.push_back(value);
+    } else {
+        const auto it = lower_bound(values.begin(), values.end(), value);
+        if (*it == value) {
+            return;
+        }
+        values.insert(it, value);
+    }
+    if (++container.cardinality > ARRAY_LIMIT) {
+        Optimize(container);
+        if (container.type == ContainerType::ARRAY) {
+            container = FromBits(ToBits(container));
+        }
+    }
+}
+
+void RoaringBitmap::ContainerRemove(Container& container, uint16_t value) {
+    if (container.type == ContainerType::RUN) {
+        Unpack(container);
+    }
+    if (container.type == ContainerType::BITMAP) {
+        uint64_t& word = container.bits[value / 64];
+        const uint64_t bit = uint64_t{1} << (value % 64);
+        if ((word & bit) != 0) {
+            word &= ~bit;
+            if (--container.cardinality <= ARRAY_LIMIT) {
+                container = FromArray(ToArray(container));
+            }
+        }
+        return;
+    }
+    auto& values = container.values;
+    const auto it = lower_bound(values.begin(), values.end(), value);
+    if (it != values.end() && *it == value) {
+        values.erase(it);
+        --container.cardinality;
+    }
+}
+
+vector<uint16_t> RoaringBitmap::ToArray(const Container& container) {
+    switch (container.type) {
+        case ContainerType::ARRAY:
+            return container.values;
+        case ContainerType::BITMAP: {
+            vector<uint16_t> values;
+            values.reserve(container.cardinality);
+            for (uint32_t word = 0; word < BITMAP_WORDS; ++word) {
+                for (uint64_t bits = container.bits[word]; bits != 0; bits &= bits - 1) {
+                    values.push_back(word * 64 + __builtin_ctzll(bits));
+                }
+            }
+            return values;
+        }
+        case ContainerType::RUN: {
+            vector<uint16_t> values;
+            values.reserve(container.cardinality);
+            for (size_t run = 0; run < container.values.size(); run += 2) {
+                const uint32_t start = container.values[run];
+                for (uint32_t value = start; value <= start + container.values[run + 1]; ++value) {
+                    values.push_back(value);
+                }
+            }
+            return values;
+        }
+    }
+    return {};
+}
+
+vector<uint64_t> RoaringBitmap::ToBits(const Container& container) {
+    if (container.type == ContainerType::BITMAP) {
+        return container.bits;
+    }
+    vector<uint64_t> bits(BITMAP_WORDS, 0);
+    if (container.type == ContainerType::ARRAY) {
+        for (const uint16_t value : container.values) {
+            bits[value / 64] |= uint64_t{1} << (value % 64);
+        }
+        return bits;
+    }
+    for (size_t run = 0; run < container.values.size(); run += 2) {
+        const uint32_t start = container.values[run];
+        for (uint32_t value = start; value <= start + container.values[run + 1]; ++value) {
+            bits[value / 64] |= uint64_t{1} << (value % 64);
+        }
+    }
+    return bits;
+}
+
+RoaringBitmap::Container RoaringBitmap::FromArray(vector<uint16_t> values) {
+    if (values.size() > ARRAY_LIMIT) {
+        Container array;
+        array.values = move(values);
+        return FromBits(ToBits(array));
+    }
+    Container container;
+    container.type = ContainerType::ARRAY;
+    container.cardinality = values.size();
+    container.values = move(values);
+    return container;
+}
+
+RoaringBitmap::Container RoaringBitmap::FromBits(vector<uint64_t> bits) {
+    uint32_t cardinality = 0;
+    for (const uint64_t word : bits) {
+        cardinality += __builtin_popcountll(word);
+    }
+    Container container;
+    container.type = ContainerType::BITMAP;
+    container.cardinality = cardinality;
+    container.bits = move(bits);
+    if (cardinality <= ARRAY_LIMIT) {
+        container.values = ToArray(container);
+        container.bits.clear();
+        container.bits.shrink_to_fit();
+        container.type = ContainerType::ARRAY;
+    }
+    return container;
+}
+
+size_t RoaringBitmap::GetPlainBytes(uint32_t cardinality) {
+    return cardinality > ARRAY_LIMIT ? BITMAP_WORDS * sizeof(uint64_t) : cardinality * sizeof(uint16_t);
+}
+
+bool RoaringBitmap::AppendToRuns(Container& container, uint16_t value) {
+    auto& runs = container.values;
+    const uint32_t last_value = static_cast<uint32_t>(runs[runs.size() - 2]) + runs.back();
+    if (value == last_value + 1) {
+        ++runs.back();
+    } else if (value > last_value + 1 && (runs.size() + 2) * sizeof(uint16_t) < GetPlainBytes(container.cardinality + 1)) {
+        runs.push_back(value);
+        runs.push_back(0);
+    } else {
+        return false;
+    }
+    ++container.cardinality;
+    return true;
+}
+
+void RoaringBitmap::Unpack(Container& container) {
+    if (container.cardinality > ARRAY_LIMIT) {
+        container = FromBits(ToBits(container));
+    } else {
+        container = FromArray(ToArray(container));
+    }
+}
+
+void RoaringBitmap::Optimize(Container& container) {
+    const auto values = ToArray(container);
+    vector<uint16_t> runs;
+    for (size_t i = 0; i < values.size(); ++i) {
+        if (!runs.empty() && static_cast<uint32_t>(runs[runs.size() - 2]) + runs.back() + 1 == values[i]) {
+            ++runs.back();
+        } else {
+            runs.push_back(values[i]);
+            runs.push_back(0);
+        }
+    }
+    const size_t run_bytes = runs.size() * sizeof(uint16_t);
+    const size_t plain_bytes = GetPlainBytes(container.cardinality);
+    if (run_bytes < plain_bytes) {
+        Container run_container;
+        run_container.type = ContainerType::RUN;
+        run_container.cardinality = container.cardinality;
+        run_container.values = move(runs);
+        container = move(run_container);
+    } else if (container.type == ContainerType::RUN) {
+        Unpack(container);
+    }
+}
+
+RoaringBitmap::Container RoaringBitmap::And(const Container& lhs, const Container& rhs) {
+    if (lhs.type == ContainerType::ARRAY || rhs.type == ContainerType::ARRAY) {
+        const Container& array = lhs.type == ContainerType::ARRAY ? lhs : rhs;
+        const Container& other = lhs.type == ContainerType::ARRAY ? rhs : lhs;
+        vector<uint16_t> values;
+        for (const uint16_t value : array.values) {
+            if (ContainerContains(other, value)) {
+                values.push_back(value);
+            }
+        }
+        return FromArray(move(values));
+    }
+    auto bits = ToBits(lhs);
+    const auto other_bits = ToBits(rhs);
+    for (uint32_t word = 0; word < BITMAP_WORDS; ++word) {
+        bits[word] &= other_bits[word];
+    }
+    return FromBits(move(bits));
+}
+
+RoaringBitmap::Container RoaringBitmap::Or(const Container& lhs, const Container& rhs) {
+    if (lhs.type == ContainerType::ARRAY && rhs.type == ContainerType::ARRAY && lhs.cardinality + rhs.cardinality <= ARRAY_LIMIT) {
+        vector<uint16_t> values;
+        values.reserve(lhs.cardinality + rhs.cardinality);
+        set_union(lhs.values.begin(), lhs.values.end(), rhs.values.begin(), rhs.values.end(), back_inserter(values));
+        return FromArray(move(values));
+    }
+    auto bits = ToBits(lhs);
+    const auto other_bits = ToBits(rhs);
+    for (uint32_t word = 0; word < BITMAP_WORDS; ++word) {
+        bits[word] |= other_bits[word];
+    }
+    return FromBits(move(bits));
+}
+
+RoaringBitmap::Container RoaringBitmap::AndNot(const Container& lhs, const Container& rhs) {
+    if (lhs.type == ContainerType::ARRAY) {
+        vector<uint16_t> values;
+        for (const uint16_t value : lhs.values) {
+            if (!ContainerContains(rhs, value)) {
+                values.push_back(value);
+            }
+        }
+        return FromArray(move(values));
+    }
+    auto bits = ToBits(lhs);
+    const auto other_bits = ToBits(rhs);
+    for (uint32_t word = 0; word < BITMAP_WORDS; ++word) {
+        bits[word] &= ~other_bits[word];
+    }
+    return FromBits(move(bits));
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+class RoaringBitmap {
+public:
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = int;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const int*;
+        using reference = int;
+
+        const_iterator() = default;
+
+        int operator*() const;
+
+        const_iterator& operator++();
+        const_iterator operator++(int);
+
+        bool operator==(const const_iterator& other) const;
+        bool operator!=(const const_iterator& other) const;
+    private:
+        friend class RoaringBitmap;
+
+        const_iterator(const RoaringBitmap* bitmap, size_t container_index);
+
+        void SkipEmpty();
+
+        const RoaringBitmap* bitmap_ = nullptr;
+        size_t container_index_ = 0;
+        uint32_t position_ = 0;
+        uint32_t run_offset_ = 0;
+    };
+
+    void Add(int value);
+
+    void Remove(int value);
+
+    bool Contains(int value) const;
+
+    size_t Count() const;
+
+    bool empty() const;
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
+    std::vector<int> ToVector() const;
+
+    RoaringBitmap& operator&=(const RoaringBitmap& other);
+    RoaringBitmap& operator|=(const RoaringBitmap& other);
+    RoaringBitmap& operator-=(const RoaringBitmap& other);
+private:
+    static const uint32_t ARRAY_LIMIT = 4096;
+    static const uint32_t BITMAP_WORDS = 1024;
+
+    enum class ContainerType : uint8_t {
+        ARRAY,
+        BITMAP,
+        RUN,
+    };
+
+    struct Container {
+        ContainerType type = ContainerType::ARRAY;
+        uint32_t cardinality = 0;
+        std::vector<uint16_t> values;
+        std::vector<uint64_t> bits;
+    };
+
+    std::vector<uint16_t> keys_;
+    std::vector<Container> containers_;
+
+    Container* FindContainer(uint16_t key);
+    const Container* FindContainer(uint16_t key) const;
+
+    static bool ContainerContains(const Container& container, uint16_t value);
+    static void ContainerAdd(Container& container, uint16_t value);
+    static void ContainerRemove(Container& container, uint16_t value);
+
+    static std::vector<uint16_t> ToArray(const Container& container);
+    static std::vector<uint64_t> ToBits(const Container& container);
+    static Container FromArray(std::vector<uint16_t> values);
+    static Container FromBits(std::vector<uint64_t> bits);
+    static size_t GetPlainBytes(uint32_t cardinality);
+    static bool AppendToRuns(Container& container, uint16_t value);
+    static void Unpack(Container& container);
+    static void Optimize(Container& container);
+
+    static Container And(const Container& lhs, const Container& rhs);
+    static Container Or(const Container& lhs, const Container& rhs);
+    static Container AndNot(const Container& lhs, const Container& rhs);
+};
@@ -0,0 +1,214 @@
+#include "score_accumulator.h"
+#include <cstring>
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define SCORE_ACCUMULATOR_X86_KERNELS
+#endif
+
+using namespace std;
+
+namespace {
+
+using AddKernel = void (*)(double* scores, uint8_t* is_matched, const int* document_ids, const double* term_freqs, size_t count, int block_begin, double weight);
+using CollectKernel = size_t (*)(const uint8_t* is_matched, size_t count, uint16_t* offsets);
+using ThresholdKernel = size_t (*)(const double* scores, const uint16_t* offsets, size_t count, double min_score, uint16_t* selected);
+
+void AddScalar(double* scores, uint8_t* is_matched, const int* document_ids, const double* term_freqs, size_t count, int block_begin, double weight) {
+    for (size_t i = 0; i < count; ++i) {
+        const int offset = document_ids[i] - block_begin;
+        scores[offset] += term_freqs[i] * weight;
+        is_matched[offset] = 1;
+    }
+}
+
+size_t CollectScalar(const uint8_t* is_matched, size_t count, uint16_t* offsets) {
+    size_t matched_count = 0;
+    for (size_t i = 0; i < count; i += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, is_matched + i, sizeof(word));
+        if (word == 0) {
+            continue;
+        }
+        for (size_t j = i; j < i + sizeof(uint64_t); ++j) {
+            if (is_matched[j]) {
+                offsets[matched_count++] = static_cast<uint16_t>(j);
+            }
+        }
+    }
+    return matched_count;
+}
+
+size_t ThresholdScalar(const double* scores, const uint16_t* offsets, size_t count, double min_score, uint16_t* selected) {
+    size_t selected_count = 0;
+    for (size_t i = 0; i < count; ++i) {
+        selected[selected_count] = offsets[i];
+        selected_count += scores[offsets[i]] >= min_score;
+    }
+    return selected_count;
+}
+
+#ifdef SCORE_ACCUMULATOR_X86_KERNELS
+__attribute__((target("avx2")))
+void AddAvx2(double* scores, uint8_t* is_matched, const int* document_ids, const double* term_freqs, size_t count, int block_begin, double weight) {
+    const __m128i base = _mm_set1_epi32(block_begin);
+    const __m256d weights = _mm256_set1_pd(weight);
+    const __m256d all_lanes = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i offsets = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(document_ids + i)), base);
+        const __m256d current = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), scores, offsets, all_lanes, sizeof(double));
+        const __m256d updated = _mm256_add_pd(current, _mm256_mul_pd(_mm256_loadu_pd(term_freqs + i), weights));
+        alignas(32) double values[4];
+        alignas(16) int lanes[4];
+        _mm256_store_pd(values, updated);
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), offsets);
+        for (int lane = 0; lane < 4; ++lane) {
+            scores[lanes[lane]] = values[lane];
+            is_matched[lanes[lane]] = 1;
+        }
+    }
+    AddScalar(scores, is_matched, document_ids + i, term_freqs + i, count - i, block_begin, weight);
+}
+
+__attribute__((target("avx2")))
+size_t CollectAvx2(const uint8_t* is_matched, size_t count, uint16_t* offsets) {
+    const __m256i zero = _mm256_setzero_si256();
+    size_t matched_count = 0;
+    for (size_t i = 0; i < count; i += 32) {
+        const __m256i flags = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(is_matched + i));
+        uint32_t mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(flags, zero)));
+        while (mask != 0) {
+            offsets[matched_count++] = static_cast<uint16_t>(i + __builtin_ctz(mask));
+            mask &= mask - 1;
+        }
+    }
+    return matched_count;
+}
+
+__attribute__((target("avx2")))
+size_t ThresholdAvx2(const double* scores, const uint16_t* offsets, size_t count, double min_score, uint16_t* selected) {
+    const __m256d threshold = _mm256_set1_pd(min_score);
+    const __m256d all_lanes = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+    size_t selected_count = 0;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i lanes = _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(offsets + i)));
+        const __m256d values = _mm256_mask_i32gather_pd(_mm256_setzero_pd(), scores, lanes, all_lanes, sizeof(double));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_pd(_mm256_cmp_pd(values, threshold, _CMP_GE_OQ)));
+        while (mask != 0) {
+            selected[selected_count++] = offsets[i + __builtin_ctz(mask)];
+            mask &= mask - 1;
+        }
+    }
+    return selected_count + ThresholdScalar(scores, offsets + i, count - i, min_score, selected + selected_count);
+}
+
+__attribute__((target("avx512f")))
+void AddAvx512(double* scores, uint8_t* is_matched, const int* document_ids, const double* term_freqs, size_t count, int block_begin, double weight) {
+    const __m256i base = _mm256_set1_epi32(block_begin);
+    const __m512d weights = _mm512_set1_pd(weight);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i offsets = _mm256_sub_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(document_ids + i)), base);
+        const __m512d current = _mm512_mask_i32gather_pd(_mm512_setzero_pd(), 0xFF, offsets, scores, sizeof(double));
+        const __m512d updated = _mm512_add_pd(current, _mm512_mul_pd(_mm512_loadu_pd(term_freqs + i), weights));
+        _mm512_i32scatter_pd(scores, offsets, updated, sizeof(double));
+        for (size_t j = i; j < i + 8; ++j) {
+            is_matched[document_ids[j] - block_begin] = 1;
+        }
+    }
+    AddScalar(scores, is_matched, document_ids + i, term_freqs + i, count - i, block_begin, weight);
+}
+#endif
+
+AddKernel GetAddKernel(SimdLevel level) {
+#ifdef SCORE_ACCUMULATOR_X86_KERNELS
+    switch (level) {
+    case SimdLevel::AVX512:
+        return AddAvx512;
+    case SimdLevel::AVX2:
+        return AddAvx2;
+    case SimdLevel::SCALAR:
+        break;
+    }
+#endif
+    return AddScalar;
+}
+
+CollectKernel GetCollectKernel(SimdLevel level) {
+#ifdef SCORE_ACCUMULATOR_X86_KERNELS
+    if (level != SimdLevel::SCALAR) {
+        return CollectAvx2;
+    }
+#endif
+    return CollectScalar;
+}
+
+ThresholdKernel GetThresholdKernel(SimdLevel level) {
+#ifdef SCORE_ACCUMULATOR_X86_KERNELS
+    if (level != SimdLevel::SCALAR) {
+        return ThresholdAvx2;
+    }
+#endif
+    return ThresholdScalar;
+}
+
+}
+
+SimdLevel GetSimdLevel() {
+#ifdef SCORE_ACCUMULATOR_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return SimdLevel::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return SimdLevel::AVX2;
+    }
+#endif
+    return SimdLevel::SCALAR;
+}
+
+void ScatterAddScores(double* scores, uint8_t* is_matched, const int* document_ids, const double* term_freqs, size_t count, int block_begin, double weight) {
+    static const AddKernel add = GetAddKernel(GetSimdLevel());
+    add(scores, is_matched, document_ids, term_freqs, count, block_begin, weight);
+}
+
+void ScatterAddScores(SimdLevel level, double* scores, uint8_t* is_matched, const int* document_ids, const double* term_freqs, size_t count, int block_begin, double weight) {
+    GetAddKernel(level)(scores, is_matched, document_ids, term_freqs, count, block_begin, weight);
+}
+
+size_t CollectMatchedOffsets(const uint8_t* is_matched, size_t count, uint16_t* offsets) {
+    static const CollectKernel collect = GetCollectKernel(GetSimdLevel());
+    return collect(is_matched, count, offsets);
+}
+
+size_t CollectMatchedOffsets(SimdLevel level, const uint8_t* is_matched, size_t count, uint16_t* offsets) {
+    return GetCollectKernel(level)(is_matched, count, offsets);
+}
+
+size_t SelectScoresAbove(const double* scores, const uint16_t* offsets, size_t count, double min_score, uint16_t* selected) {
+    static const ThresholdKernel threshold = GetThresholdKernel(GetSimdLevel());
+    return threshold(scores, offsets, count, min_score, selected);
+}
+
+size_t SelectScoresAbove(SimdLevel level, const double* scores, const uint16_t* offsets, size_t count, double min_score, uint16_t* selected) {
+    return GetThresholdKernel(level)(scores, offsets, count, min_score, selected);
+}
+
+ScoreAccumulator::ScoreAccumulator(pmr::memory_resource* resource)
+    : scores_(BLOCK_SIZE, 0.0, resource)
+    , is_matched_(BLOCK_SIZE, 0, resource)
+    , matched_offsets_(BLOCK_SIZE, resource)
+    , selected_offsets_(BLOCK_SIZE, resource)
+    , positions_(resource) {
+}
+
+void ScoreAccumulator::AddBlock(const WeightedPostingList& term, size_t first, size_t last, int block_begin) {
+    ScatterAddScores(scores_.data(), is_matched_.data(), term.postings->GetDocumentIds().data() + first,
+                     term.postings->GetTermFreqs().data() + first, last - first, block_begin, term.weight);
+}
+
+size_t ScoreAccumulator::CollectMatched() {
+    return CollectMatchedOffsets(is_matched_.data(), BLOCK_SIZE, matched_offsets_.data());
+}
@@ -0,0 +1,101 @@
+#pragma once
+#include <algorithm>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+#include "posting_list.h"
+
+struct WeightedPostingList {
+    const PostingList* postings;
+    double weight;
+};
+
+enum class SimdLevel {
+    SCALAR,
+    AVX2,
+    AVX512,
+};
+
+SimdLevel GetSimdLevel();
+
+void ScatterAddScores(double* scores, uint8_t* is_matched, const int* document_ids, const double* term_freqs, size_t count, int block_begin, double weight);
+
+void ScatterAddScores(SimdLevel level, double* scores, uint8_t* is_matched, const int* document_ids, const double* term_freqs, size_t count, int block_begin, double weight);
+
+size_t CollectMatchedOffsets(const uint8_t* is_matched, size_t count, uint16_t* offsets);
+size_t CollectMatchedOffsets(SimdLevel level, const uint8_t* is_matched, size_t count, uint16_t* offsets);
+
+size_t SelectScoresAbove(const double* scores, const uint16_t* offsets, size_t count, double min_score, uint16_t* selected);
+size_t SelectScoresAbove(SimdLevel level, const double* scores, const uint16_t* offsets, size_t count, double min_score, uint16_t* selected);
+
+class ScoreAccumulator {
+public:
+    static const int BLOCK_SIZE = 4096;
+
+    explicit ScoreAccumulator(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+    template <typename Callback>
+    void Accumulate(const std::pmr::vector<WeightedPostingList>& terms, int first_document_id, int last_document_id, const double& min_score, Callback callback);
+private:
+    std::pmr::vector<double> scores_;
+    std::pmr::vector<uint8_t> is_matched_;
+    std::pmr::vector<uint16_t> matched_offsets_;
+    std::pmr::vector<uint16_t> selected_offsets_;
+    std::pmr::vector<size_t> positions_;
+
+    void AddBlock(const WeightedPostingList& term, size_t first, size_t last, int block_begin);
+
+    size_t CollectMatched();
+};
+
+template <typename Callback>
+void ScoreAccumulator::Accumulate(const std::pmr::vector<WeightedPostingList>& terms, int first_document_id, int last_document_id, const double& min_score, Callback callback) {
+    positions_.resize(terms.size());
+    for (size_t i = 0; i < terms.size(); ++i) {
+        const auto& document_ids = terms[i].postings->GetDocumentIds();
+        positions_[i] = std::lower_bound(document_ids.begin(), document_ids.end(), first_document_id) - document_ids.begin();
+    }
+
+    while (true) {
+        bool has_postings = false;
+        int block_begin = INT_MAX;
+        for (size_t i = 0; i < terms.size(); ++i) {
+            const auto& document_ids = terms[i].postings->GetDocumentIds();
+            if (positions_[i] < document_ids.size()) {
+                has_postings = true;
+                block_begin = std::min(block_begin, document_ids[positions_[i]]);
+            }
+        }
+        if (!has_postings || block_begin > last_document_id) {
+            return;
+        }
+        const int block_last = static_cast<int>(std::min<int64_t>(static_cast<int64_t>(block_begin) + BLOCK_SIZE - 1, last_document_id));
+
+        for (size_t i = 0; i < terms.size(); ++i) {
+            const auto& document_ids = terms[i].postings->GetDocumentIds();
+            const size_t first = positions_[i];
+            const size_t last = std::upper_bound(document_ids.begin() + first, document_ids.end(), block_last) - document_ids.begin();
+            if (first < last) {
+                AddBlock(terms[i], first, last, block_begin);
+            }
+            positions_[i] = last;
+        }
+
+        const size_t matched_count = CollectMatched();
+        const size_t selected_count = SelectScoresAbove(scores_.data(), matched_offsets_.data(), matched_count, min_score, selected_offsets_.data());
+        for (size_t i = 0; i < selected_count; ++i) {
+            const uint16_t offset = selected_offsets_[i];
+            callback(block_begin + offset, scores_[offset]);
+        }
+        for (size_t i = 0; i < matched_count; ++i) {
+            const uint16_t offset = matched_offsets_[i];
+            scores_[offset] = 0.0;
+            is_matched_[offset] = 0;
+        }
+        if (block_last == last_document_id) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,28 @@
+#include "scratch_arena.h"
+
+using namespace std;
+
+ScratchArena::ThreadArena::ThreadArena()
+    : buffer(make_unique<byte[]>(INITIAL_BUFFER_SIZE))
+    , resource(buffer.get(), INITIAL_BUFFER_SIZE) {
+}
+
+ScratchArena::ScratchArena()
+    : arena_(GetThreadArena()) {
+    ++arena_.depth;
+}
+
+ScratchArena::~ScratchArena() {
+    if (--arena_.depth == 0) {
+        arena_.resource.release();
+    }
+}
+
+pmr::memory_resource* ScratchArena::GetResource() const {
+    return &arena_.resource;
+}
+
+ScratchArena::ThreadArena& ScratchArena::GetThreadArena() {
+    static thread_local ThreadArena arena;
+    return arena;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+
+class ScratchArena {
+public:
+    ScratchArena();
+
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    ~ScratchArena();
+
+    std::pmr::memory_resource* GetResource() const;
+private:
+    static const size_t INITIAL_BUFFER_SIZE = 256 * 1024;
+
+    struct ThreadArena {
+        ThreadArena();
+
+        std::unique_ptr<std::byte[]> buffer;
+        std::pmr::monotonic_buffer_resource resource;
+        int depth = 0;
+    };
+
+    ThreadArena& arena_;
+
+    static ThreadArena& GetThreadArena();
+};
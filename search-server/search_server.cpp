@@ -2,6 +2,9 @@
 #include <cmath>
 #include <numeric>
 #include <iterator>
+#include <charconv>
+#include <limits>
+#include <chrono>
 
 using namespace std;
 
@@ -9,50 +12,644 @@ SearchServer::SearchServer(const string& stop_words_text) : SearchServer(string_
 
 SearchServer::SearchServer(const std::string_view stop_words_text) : SearchServer(SplitIntoWords(stop_words_text)) {}
 
+void SearchServer::EnablePositionalIndex() {
+    if (!documents_.empty()) {
+        throw logic_error("Positional index must be enabled before adding documents"s);
+    }
+    positional_index_.emplace();
+}
+
+void SearchServer::SetTextNormalization(const NormalizationOptions& options) {
+    if (!documents_.empty()) {
+        throw logic_error("Text normalization must be set before adding documents"s);
+    }
+    text_normalizer_ = TextNormalizer(options);
+    if (!text_normalizer_.IsEnabled()) {
+        return;
+    }
+    set<string, less<>> stop_words;
+    for (const string& word : stop_words_) {
+        deque<string> normalized_words;
+        vector<string_view> tokens;
+        text_normalizer_.Tokenize(word, normalized_words, tokens);
+        stop_words.insert(tokens.begin(), tokens.end());
+    }
+    stop_words_ = move(stop_words);
+}
+
 void SearchServer::AddDocument(int document_id, const string_view document, DocumentStatus status, const vector<int>& ratings) {
-    if ((document_id < 0) || (document_ids_.count(document_id) > 0)) {
+    if ((document_id < 0) || document_ids_.Contains(document_id)) {
+        throw invalid_argument("Invalid document_id"s);
+    }
+    AddPreparedDocument(PrepareDocument(document_id, document, status, ratings));
+}
+
+PreparedDocument SearchServer::PrepareDocument(int document_id, const string_view document, DocumentStatus status, const vector<int>& ratings) const {
+    PreparedDocument prepared_document{document_id, status, ComputeAverageRating(ratings), {}, {}};
+    prepared_document.words = SplitIntoWordsNoStop(document, prepared_document.normalized_words);
+    return prepared_document;
+}
+
+void SearchServer::AddPreparedDocument(const PreparedDocument& document) {
+    const int document_id = document.id;
+    if ((document_id < 0) || document_ids_.Contains(document_id)) {
         throw invalid_argument("Invalid document_id"s);
     }
-    const auto words = SplitIntoWordsNoStop(document);
+    const auto& words = document.words;
 
     const double inv_word_count = 1.0 / words.size();
+    vector<int> term_ids;
+    term_ids.reserve(words.size());
+    vector<TermFrequency> term_freqs;
+    term_freqs.reserve(words.size());
     for (const string_view word : words) {
-        document_to_word_freqs_[document_id][string(word)] += inv_word_count;
-        word_to_document_freqs_[document_to_word_freqs_[document_id].find(word)->first][document_id] += inv_word_count;
+        const int term_id = term_dictionary_.Insert(word);
+        while (term_id >= static_cast<int>(word_to_document_freqs_.size())) {
+            word_to_document_freqs_.emplace_back(&index_memory_);
+        }
+        PostingList& postings = word_to_document_freqs_[term_id];
+        const size_t posting_count = postings.size();
+        postings.Add(document_id, inv_word_count);
+        posting_stats_.OnPostingCountChanged(term_id, posting_count, postings.size());
+        term_ids.push_back(term_id);
+        term_freqs.push_back({term_id, inv_word_count});
     }
-    documents_.emplace(document_id, DocumentData{ComputeAverageRating(ratings), status});
-    document_ids_.insert(document_id);
+    forward_index_.AddDocument(document_id, move(term_freqs));
+    documents_.emplace(document_id, DocumentData{document.rating, document.status});
+    document_ids_.Add(document_id);
+    attribute_index_.AddDocument(document_id, document.status, document.rating);
+
+    if (positional_index_) {
+        positional_index_->AddDocument(document_id, term_ids);
+    }
+    UpdateSubscriptions(document_id);
 }
 
 vector<Document> SearchServer::FindTopDocuments(const string_view& raw_query, DocumentStatus status) const {
-    return FindTopDocuments(execution::seq, raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
-        return document_status == status;
+    return FindTopDocuments(raw_query, DocumentFilter{{status}});
+}
+
+vector<Document> SearchServer::FindTopDocuments(const string_view raw_query, const DocumentFilter& filter) const {
+    QueryStats stats;
+    return FindTopDocuments(raw_query, filter, stats);
+}
+
+vector<Document> SearchServer::FindTopDocuments(const string_view raw_query, const DocumentFilter& filter, QueryStats& stats) const {
+    const auto query = ParseQuery(execution::seq, raw_query);
+    ThreadPool& pool = ThreadPool::GetDefault();
+
+    RoaringBitmap allowed_documents = attribute_index_.Select(filter);
+    stats = PlanFilteredQuery(query, allowed_documents, pool.GetThreadCount());
+
+    auto matched_documents = stats.mode == ExecutionMode::PARALLEL
+                             ? EvaluateFilteredQuery(pool, query, allowed_documents, stats.strategy, MAX_RESULT_DOCUMENT_COUNT)
+                             : EvaluateFilteredQuery(execution::seq, query, allowed_documents, stats.strategy, MAX_RESULT_DOCUMENT_COUNT);
+
+    SortTopDocuments(execution::seq, matched_documents);
+    return matched_documents;
+}
+
+vector<Document> SearchServer::FindTopDocuments(execution::sequenced_policy policy, const string_view raw_query, DocumentStatus status) const {
+    return FindTopDocuments(policy, raw_query, DocumentFilter{{status}});
+}
+
+vector<Document> SearchServer::FindTopDocuments(execution::parallel_policy, const string_view raw_query, DocumentStatus status) const {
+    return FindTopDocuments(ThreadPool::GetDefault(), raw_query, status);
+}
+
+vector<Document> SearchServer::FindTopDocuments(execution::sequenced_policy policy, const string_view raw_query, const DocumentFilter& filter) const {
+    const auto query = ParseQuery(policy, raw_query);
+
+    auto matched_documents = FindFilteredDocuments(policy, query, attribute_index_.Select(filter), MAX_RESULT_DOCUMENT_COUNT);
+
+    SortTopDocuments(policy, matched_documents);
+    return matched_documents;
+}
+
+vector<Document> SearchServer::FindTopDocuments(execution::parallel_policy, const string_view raw_query, const DocumentFilter& filter) const {
+    return FindTopDocuments(ThreadPool::GetDefault(), raw_query, filter);
+}
+
+vector<Document> SearchServer::FindTopDocuments(ThreadPool& pool, const string_view raw_query) const {
+    return FindTopDocuments(pool, raw_query, DocumentStatus::ACTUAL);
+}
+
+vector<Document> SearchServer::FindTopDocuments(ThreadPool& pool, const string_view raw_query, DocumentStatus status) const {
+    return FindTopDocuments(pool, raw_query, DocumentFilter{{status}});
+}
+
+vector<Document> SearchServer::FindTopDocuments(ThreadPool& pool, const string_view raw_query, const DocumentFilter& filter) const {
+    const auto query = ParseQuery(execution::seq, raw_query);
+
+    auto matched_documents = FindFilteredDocuments(pool, query, attribute_index_.Select(filter), MAX_RESULT_DOCUMENT_COUNT);
+
+    SortTopDocuments(execution::seq, matched_documents);
+    return matched_documents;
+}
+
+vector<Document> SearchServer::FindTopDocuments(execution::sequenced_policy policy, const string_view raw_query, const DocumentFilter& filter, const CorpusStatistics& statistics) const {
+    const auto query = ParseQuery(policy, raw_query, &statistics);
+
+    auto matched_documents = FindFilteredDocuments(policy, query, attribute_index_.Select(filter), MAX_RESULT_DOCUMENT_COUNT);
+
+    SortTopDocuments(policy, matched_documents);
+    return matched_documents;
+}
+
+DocumentPage SearchServer::FindTopDocumentsPage(const string_view raw_query, size_t offset, size_t limit) const {
+    return FindTopDocumentsPage(raw_query, DocumentFilter{{DocumentStatus::ACTUAL}}, offset, limit);
+}
+
+DocumentPage SearchServer::FindTopDocumentsPage(const string_view raw_query, const PageCursor& after, size_t limit) const {
+    return FindTopDocumentsPage(raw_query, DocumentFilter{{DocumentStatus::ACTUAL}}, after, limit);
+}
+
+DocumentPage SearchServer::FindTopDocumentsPage(const string_view raw_query, const DocumentFilter& filter, size_t offset, size_t limit) const {
+    const auto query = ParseQuery(execution::seq, raw_query);
+
+    const size_t document_limit = offset < numeric_limits<size_t>::max() - limit ? offset + limit + 1 : numeric_limits<size_t>::max();
+    auto matched_documents = FindFilteredDocuments(execution::seq, query, attribute_index_.Select(filter), document_limit);
+
+    return SelectPage(move(matched_documents), offset, limit);
+}
+
+DocumentPage SearchServer::FindTopDocumentsPage(const string_view raw_query, const DocumentFilter& filter, const PageCursor& after, size_t limit) const {
+    const auto query = ParseQuery(execution::seq, raw_query);
+
+    const Document last_document(after.id, after.relevance, after.rating);
+    const size_t document_limit = limit < numeric_limits<size_t>::max() ? limit + 1 : limit;
+    auto matched_documents = FindFilteredDocuments(execution::seq, query, attribute_index_.Select(filter), document_limit, &last_document);
+    matched_documents.erase(remove_if(matched_documents.begin(), matched_documents.end(), [&last_document](const Document& document) {
+        return !IsRankedHigher(last_document, document);
+    }), matched_documents.end());
+
+    return SelectPage(move(matched_documents), 0, limit);
+}
+
+vector<vector<Document>> SearchServer::FindTopDocumentsBatch(const vector<string>& raw_queries, DocumentStatus status) const {
+    return EvaluateBatch(execution::seq, raw_queries, status);
+}
+
+vector<vector<Document>> SearchServer::FindTopDocumentsBatch(ThreadPool& pool, const vector<string>& raw_queries, DocumentStatus status) const {
+    return EvaluateBatch(pool, raw_queries, status);
+}
+
+void SearchServer::ForEachIndex(execution::sequenced_policy, size_t count, const function<void(size_t)>& function) {
+    for (size_t i = 0; i < count; ++i) {
+        function(i);
+    }
+}
+
+void SearchServer::ForEachIndex(ThreadPool& pool, size_t count, const function<void(size_t)>& function) {
+    pool.ParallelFor(count, function);
+}
+
+template <typename Executor>
+vector<vector<Document>> SearchServer::EvaluateBatch(Executor&& executor, const vector<string>& raw_queries, DocumentStatus status) const {
+    vector<Query> queries(raw_queries.size());
+    ForEachIndex(executor, raw_queries.size(), [&](size_t i) {
+        queries[i] = ParseQuery(execution::seq, raw_queries[i]);
+    });
+    const RoaringBitmap allowed_documents = attribute_index_.Select(DocumentFilter{{status}});
+
+    vector<size_t> boolean_queries;
+    vector<size_t> batched_queries;
+    for (size_t i = 0; i < queries.size(); ++i) {
+        (queries[i].is_boolean ? boolean_queries : batched_queries).push_back(i);
+    }
+
+    vector<vector<Document>> results(queries.size());
+    ForEachIndex(executor, boolean_queries.size(), [&](size_t i) {
+        const size_t query_id = boolean_queries[i];
+        results[query_id] = FindFilteredDocuments(execution::seq, queries[query_id], allowed_documents, MAX_RESULT_DOCUMENT_COUNT);
+        SortTopDocuments(execution::seq, results[query_id]);
     });
+    const size_t batch_count = (batched_queries.size() + BATCH_QUERY_COUNT - 1) / BATCH_QUERY_COUNT;
+    ForEachIndex(executor, batch_count, [&](size_t batch) {
+        const size_t first = batch * BATCH_QUERY_COUNT;
+        const size_t count = min(BATCH_QUERY_COUNT, batched_queries.size() - first);
+        EvaluateQueryBatch(queries, batched_queries.data() + first, count, allowed_documents, results);
+    });
+    return results;
+}
+
+void SearchServer::EvaluateQueryBatch(const vector<Query>& queries, const size_t* query_ids, size_t query_count, const RoaringBitmap& allowed_documents, vector<vector<Document>>& results) const {
+    struct BatchTerm {
+        const PostingList* postings = nullptr;
+        size_t position = 0;
+        vector<pair<size_t, double>> users;
+    };
+
+    map<string_view, BatchTerm> terms;
+    vector<RoaringBitmap> excluded_documents(query_count);
+    for (size_t query = 0; query < query_count; ++query) {
+        const Query& current = queries[query_ids[query]];
+        excluded_documents[query] = CollectExcludedDocuments(current);
+        for (const string_view word : current.plus_words) {
+            const auto* document_freqs = FindWordDocumentFreqs(word);
+            if (document_freqs == nullptr) {
+                continue;
+            }
+            BatchTerm& term = terms[word];
+            term.postings = document_freqs;
+            term.users.emplace_back(query, ComputeWordInverseDocumentFreq(current, word, document_freqs->size()));
+        }
+    }
+
+    ScratchArena scratch;
+    pmr::vector<double> scores(query_count * BATCH_BLOCK_SIZE, 0.0, scratch.GetResource());
+    pmr::vector<uint8_t> is_matched(query_count * BATCH_BLOCK_SIZE, 0, scratch.GetResource());
+    pmr::vector<uint16_t> offsets(BATCH_BLOCK_SIZE, scratch.GetResource());
+    pmr::vector<uint16_t> selected_offsets(BATCH_BLOCK_SIZE, scratch.GetResource());
+    vector<char> is_touched(query_count, false);
+    vector<vector<Document>> top_documents(query_count);
+    vector<double> min_scores(query_count, -numeric_limits<double>::infinity());
+
+    while (true) {
+        bool has_postings = false;
+        int block_begin = INT_MAX;
+        for (const auto& [word, term] : terms) {
+            const auto& document_ids = term.postings->GetDocumentIds();
+            if (term.position < document_ids.size()) {
+                has_postings = true;
+                block_begin = min(block_begin, document_ids[term.position]);
+            }
+        }
+        if (!has_postings) {
+            break;
+        }
+        const int block_last = static_cast<int>(min<int64_t>(static_cast<int64_t>(block_begin) + BATCH_BLOCK_SIZE - 1, INT_MAX));
+
+        for (auto& [word, term] : terms) {
+            const auto& document_ids = term.postings->GetDocumentIds();
+            const size_t first = term.position;
+            const size_t last = upper_bound(document_ids.begin() + first, document_ids.end(), block_last) - document_ids.begin();
+            if (first == last) {
+                continue;
+            }
+            for (const auto& [query, weight] : term.users) {
+                ScatterAddScores(scores.data() + query * BATCH_BLOCK_SIZE, is_matched.data() + query * BATCH_BLOCK_SIZE,
+                                 document_ids.data() + first, term.postings->GetTermFreqs().data() + first, last - first, block_begin, weight);
+                is_touched[query] = true;
+            }
+            term.position = last;
+        }
+
+        for (size_t query = 0; query < query_count; ++query) {
+            if (!is_touched[query]) {
+                continue;
+            }
+            is_touched[query] = false;
+            double* query_scores = scores.data() + query * BATCH_BLOCK_SIZE;
+            uint8_t* query_matches = is_matched.data() + query * BATCH_BLOCK_SIZE;
+            const size_t matched_count = CollectMatchedOffsets(query_matches, BATCH_BLOCK_SIZE, offsets.data());
+            const size_t selected_count = SelectScoresAbove(query_scores, offsets.data(), matched_count, min_scores[query], selected_offsets.data());
+            for (size_t i = 0; i < selected_count; ++i) {
+                const int document_id = block_begin + selected_offsets[i];
+                if (allowed_documents.Contains(document_id) && !excluded_documents[query].Contains(document_id)) {
+                    AddRankedDocument(top_documents[query], MAX_RESULT_DOCUMENT_COUNT, {document_id, query_scores[selected_offsets[i]], documents_.at(document_id).rating});
+                    min_scores[query] = GetRankedScoreThreshold(top_documents[query], MAX_RESULT_DOCUMENT_COUNT);
+                }
+            }
+            for (size_t i = 0; i < matched_count; ++i) {
+                query_scores[offsets[i]] = 0.0;
+                query_matches[offsets[i]] = 0;
+            }
+        }
+        if (block_last == INT_MAX) {
+            break;
+        }
+    }
+
+    for (size_t query = 0; query < query_count; ++query) {
+        SortTopDocuments(execution::seq, top_documents[query]);
+        results[query_ids[query]] = move(top_documents[query]);
+    }
+}
+
+CorpusStatistics SearchServer::CollectStatistics(const string_view raw_query) const {
+    const auto query = ParseQuery(execution::seq, raw_query);
+    CorpusStatistics statistics;
+    statistics.document_count = GetDocumentCount();
+    for (const string_view word : query.plus_words) {
+        const auto* document_freqs = FindWordDocumentFreqs(word);
+        statistics.document_freqs.emplace(word, document_freqs == nullptr ? 0 : document_freqs->size());
+    }
+    CollectQueryNodeStatistics(query.root, statistics);
+    return statistics;
+}
+
+void SearchServer::CollectQueryNodeStatistics(const QueryNode& node, CorpusStatistics& statistics) const {
+    if (!node.word.empty() && statistics.document_freqs.count(node.word) == 0) {
+        const auto* document_freqs = FindWordDocumentFreqs(node.word);
+        statistics.document_freqs.emplace(node.word, document_freqs == nullptr ? 0 : document_freqs->size());
+    }
+    for (const QueryNode& child : node.children) {
+        CollectQueryNodeStatistics(child, statistics);
+    }
 }
 
 vector<Document> SearchServer::FindTopDocuments(const string_view& raw_query) const {
     return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
 }
 
+IndexStats SearchServer::GetIndexStats() const {
+    IndexStats stats;
+    stats.document_count = GetDocumentCount();
+    stats.vocabulary_size = posting_stats_.GetVocabularySize();
+    stats.total_postings = posting_stats_.GetTotalPostings();
+    stats.posting_length_histogram = posting_stats_.GetHistogram();
+
+    stats.word_to_document_freqs.entry_count = stats.total_postings;
+    for (const PostingList& postings : word_to_document_freqs_) {
+        stats.word_to_document_freqs.memory += postings.GetMemoryUsage();
+    }
+    stats.word_to_document_freqs.memory.allocated_bytes += (word_to_document_freqs_.capacity() - word_to_document_freqs_.size()) * sizeof(PostingList);
+
+    stats.document_to_word_freqs.entry_count = forward_index_.GetEntryCount();
+    stats.document_to_word_freqs.removed_entry_count = forward_index_.GetRemovedEntryCount();
+    stats.document_to_word_freqs.memory = forward_index_.GetMemoryUsage();
+
+    stats.documents.entry_count = documents_.size();
+    stats.documents.memory = EstimateTreeMemory(documents_.size(), sizeof(decltype(documents_)::value_type));
+
+    stats.stop_words.entry_count = stop_words_.size();
+    stats.stop_words.memory = EstimateTreeMemory(stop_words_.size(), sizeof(string));
+    for (const string& word : stop_words_) {
+        stats.stop_words.memory.used_bytes += word.size();
+        if (word.capacity() > string().capacity()) {
+            stats.stop_words.memory.allocated_bytes += word.capacity() + 1;
+        }
+    }
+
+    stats.term_dictionary.entry_count = term_dictionary_.size();
+    stats.term_dictionary.removed_entry_count = term_dictionary_.size() - stats.vocabulary_size;
+    stats.term_dictionary.memory = term_dictionary_.GetMemoryUsage();
+
+    for (const auto& [term_id, posting_count] : posting_stats_.GetHeaviestTerms()) {
+        stats.heaviest_terms.push_back({term_dictionary_.GetTerm(term_id), posting_count, posting_count * (sizeof(int) + sizeof(double))});
+    }
+    return stats;
+}
+
+int SearchServer::AddSubscription(const string_view raw_query, DocumentStatus status) {
+    const int subscription_id = next_subscription_id_++;
+    Subscription& subscription = subscriptions_[subscription_id];
+    subscription.raw_query = string(raw_query);
+    subscription.status = status;
+    try {
+        EvaluateSubscription(subscription_id, subscription);
+    } catch (...) {
+        subscriptions_.erase(subscription_id);
+        throw;
+    }
+    return subscription_id;
+}
+
+void SearchServer::RemoveSubscription(int subscription_id) {
+    const auto it = subscriptions_.find(subscription_id);
+    if (it == subscriptions_.end()) {
+        throw invalid_argument("Invalid subscription_id"s);
+    }
+    subscription_index_.Remove(subscription_id, it->second.query.plus_words);
+    subscriptions_.erase(it);
+}
+
+const vector<Document>& SearchServer::GetSubscriptionTopDocuments(int subscription_id) {
+    const auto it = subscriptions_.find(subscription_id);
+    if (it == subscriptions_.end()) {
+        throw invalid_argument("Invalid subscription_id"s);
+    }
+    Subscription& subscription = it->second;
+    if (subscription.is_stale || added_document_count_ - subscription.evaluated_at >= subscription_refresh_interval_) {
+        EvaluateSubscription(subscription_id, subscription);
+    }
+    return subscription.top_documents;
+}
+
+vector<int> SearchServer::TakeUpdatedSubscriptions() {
+    vector<int> subscription_ids;
+    for (const int subscription_id : updated_subscriptions_) {
+        const auto it = subscriptions_.find(subscription_id);
+        if (it != subscriptions_.end() && it->second.is_updated) {
+            it->second.is_updated = false;
+            subscription_ids.push_back(subscription_id);
+        }
+    }
+    updated_subscriptions_.clear();
+    sort(subscription_ids.begin(), subscription_ids.end());
+    return subscription_ids;
+}
+
+void SearchServer::SetSubscriptionRefreshInterval(size_t document_count) {
+    subscription_refresh_interval_ = document_count;
+}
+
+void SearchServer::EvaluateSubscription(int subscription_id, Subscription& subscription) {
+    Query query = ParseQuery(execution::seq, subscription.raw_query);
+    subscription_index_.Remove(subscription_id, subscription.query.plus_words);
+    subscription.query = move(query);
+    subscription_index_.Add(subscription_id, subscription.query.plus_words);
+
+    subscription.top_documents = FindFilteredDocuments(execution::seq, subscription.query, attribute_index_.Select(DocumentFilter{{subscription.status}}), MAX_RESULT_DOCUMENT_COUNT);
+    SortTopDocuments(execution::seq, subscription.top_documents);
+    subscription.evaluated_at = added_document_count_;
+    subscription.is_stale = false;
+}
+
+void SearchServer::MarkSubscriptionUpdated(int subscription_id, Subscription& subscription) {
+    if (!subscription.is_updated) {
+        subscription.is_updated = true;
+        updated_subscriptions_.push_back(subscription_id);
+    }
+}
+
+void SearchServer::UpdateSubscriptions(int document_id) {
+    ++added_document_count_;
+    if (subscriptions_.empty()) {
+        return;
+    }
+    struct DocumentTerm {
+        string_view word;
+        double term_freq;
+        size_t document_freq;
+    };
+    vector<DocumentTerm> document_terms;
+    vector<int> subscription_ids;
+    const auto [first, last] = forward_index_.Find(document_id);
+    for (auto it = first; it != last; ++it) {
+        const string_view word = term_dictionary_.GetTerm(it->term_id);
+        document_terms.push_back({word, it->term_freq, word_to_document_freqs_[it->term_id].size()});
+        if (const auto* word_subscriptions = subscription_index_.Find(word)) {
+            subscription_ids.insert(subscription_ids.end(), word_subscriptions->begin(), word_subscriptions->end());
+        }
+    }
+    sort(subscription_ids.begin(), subscription_ids.end());
+    subscription_ids.erase(unique(subscription_ids.begin(), subscription_ids.end()), subscription_ids.end());
+    sort(document_terms.begin(), document_terms.end(), [](const DocumentTerm& lhs, const DocumentTerm& rhs) {
+        return lhs.word < rhs.word;
+    });
+    const auto find_term = [&document_terms](string_view word) {
+        const auto it = lower_bound(document_terms.begin(), document_terms.end(), word, [](const DocumentTerm& term, string_view value) {
+            return term.word < value;
+        });
+        return it != document_terms.end() && it->word == word ? &*it : nullptr;
+    };
+
+    const DocumentData& document_data = documents_.at(document_id);
+    for (const int subscription_id : subscription_ids) {
+        Subscription& subscription = subscriptions_.at(subscription_id);
+        const Query& query = subscription.query;
+        if (subscription.is_stale || subscription.status != document_data.status) {
+            continue;
+        }
+        if (query.is_boolean) {
+            ResolveQueryPhrases(subscription.query);
+        }
+        if (query.is_boolean ? !MatchesQueryNode(query, query.root, document_id)
+                             : any_of(query.minus_words.begin(), query.minus_words.end(), find_term)) {
+            continue;
+        }
+        double relevance = 0.0;
+        for (const string_view word : query.plus_words) {
+            if (const DocumentTerm* term = find_term(word)) {
+                relevance += term->term_freq * ComputeWordInverseDocumentFreq(query, word, term->document_freq);
+            }
+        }
+        relevance *= ComputeProximityBoost(query, document_id);
+        const Document document = {document_id, relevance, document_data.rating};
+        auto& top_documents = subscription.top_documents;
+        const auto position = upper_bound(top_documents.begin(), top_documents.end(), document, IsRankedHigher);
+        if (position == top_documents.end() && top_documents.size() >= MAX_RESULT_DOCUMENT_COUNT) {
+            continue;
+        }
+        top_documents.insert(position, document);
+        if (top_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
+            top_documents.pop_back();
+        }
+        MarkSubscriptionUpdated(subscription_id, subscription);
+    }
+}
+
+void SearchServer::InvalidateSubscriptions(int document_id) {
+    if (subscriptions_.empty()) {
+        return;
+    }
+    const auto [first, last] = forward_index_.Find(document_id);
+    for (auto it = first; it != last; ++it) {
+        const auto* word_subscriptions = subscription_index_.Find(term_dictionary_.GetTerm(it->term_id));
+        if (word_subscriptions == nullptr) {
+            continue;
+        }
+        for (const int subscription_id : *word_subscriptions) {
+            Subscription& subscription = subscriptions_.at(subscription_id);
+            const bool is_top = any_of(subscription.top_documents.begin(), subscription.top_documents.end(), [document_id](const Document& document) {
+                return document.id == document_id;
+            });
+            if (is_top) {
+                subscription.is_stale = true;
+                MarkSubscriptionUpdated(subscription_id, subscription);
+            }
+        }
+    }
+}
+
+void SearchServer::SetQueryPlannerThresholds(const QueryPlannerThresholds& thresholds) {
+    query_planner_ = QueryPlanner(thresholds);
+}
+
+const QueryPlannerThresholds& SearchServer::GetQueryPlannerThresholds() const {
+    return query_planner_.GetThresholds();
+}
+
+QueryPlannerThresholds SearchServer::CalibrateQueryPlanner(const vector<string>& sample_queries) {
+    const int REPEAT_COUNT = 3;
+    const auto measure = [REPEAT_COUNT](const auto& function) {
+        double best_time = numeric_limits<double>::max();
+        for (int i = 0; i < REPEAT_COUNT; ++i) {
+            const auto start = chrono::steady_clock::now();
+            function();
+            best_time = min(best_time, chrono::duration<double>(chrono::steady_clock::now() - start).count());
+        }
+        return best_time;
+    };
+
+    ThreadPool& pool = ThreadPool::GetDefault();
+    const vector<int> all_documents = document_ids_.ToVector();
+    const auto is_any = [](int) {
+        return true;
+    };
+    vector<ExecutionSample> find_samples;
+    vector<ExecutionSample> match_samples;
+    vector<double> candidate_costs;
+    for (const string& raw_query : sample_queries) {
+        const auto query = ParseQuery(execution::seq, raw_query);
+        const size_t posting_count = CountQueryPostings(query);
+        if (query.is_boolean || posting_count == 0) {
+            continue;
+        }
+
+        ExecutionSample find_sample;
+        find_sample.cost = posting_count;
+        find_sample.sequential_time = measure([&] {
+            FindAllDocuments(execution::seq, query, RoaringBitmap{}, is_any, MAX_RESULT_DOCUMENT_COUNT);
+        });
+        find_sample.parallel_time = measure([&] {
+            FindAllDocuments(pool, query, RoaringBitmap{}, is_any, MAX_RESULT_DOCUMENT_COUNT);
+        });
+        find_samples.push_back(find_sample);
+
+        if (find_sample.sequential_time <= 0.0) {
+            continue;
+        }
+        const double document_at_a_time = measure([&] {
+            FindDocumentsInSet(query, all_documents);
+        });
+        const double candidate_work = static_cast<double>(all_documents.size()) * query.plus_words.size();
+        candidate_costs.push_back(document_at_a_time / candidate_work / (find_sample.sequential_time / posting_count));
+
+        if (!all_documents.empty()) {
+            ExecutionSample match_sample;
+            match_sample.cost = SplitIntoWords(raw_query).size();
+            match_sample.sequential_time = measure([&] {
+                MatchDocument(execution::seq, raw_query, all_documents.front());
+            });
+            match_sample.parallel_time = measure([&] {
+                MatchDocument(pool, raw_query, all_documents.front());
+            });
+            match_samples.push_back(match_sample);
+        }
+    }
+    if (find_samples.empty()) {
+        return query_planner_.GetThresholds();
+    }
+
+    QueryPlannerThresholds thresholds = query_planner_.GetThresholds();
+    thresholds.parallel_posting_count = QueryPlanner::FitParallelThreshold(find_samples);
+    thresholds.parallel_match_term_count = QueryPlanner::FitParallelThreshold(match_samples);
+    if (!candidate_costs.empty()) {
+        nth_element(candidate_costs.begin(), candidate_costs.begin() + candidate_costs.size() / 2, candidate_costs.end());
+        thresholds.candidate_cost = candidate_costs[candidate_costs.size() / 2];
+    }
+    SetQueryPlannerThresholds(thresholds);
+    return thresholds;
+}
+
 int SearchServer::GetDocumentCount() const {
     return documents_.size();
 }
 
-set<int>::const_iterator SearchServer::begin() const {
+RoaringBitmap::const_iterator SearchServer::begin() const {
     return document_ids_.begin();
 }
 
-set<int>::const_iterator SearchServer::end() const {
+RoaringBitmap::const_iterator SearchServer::end() const {
     return document_ids_.end();
 }
 
-const map<string_view, double>& SearchServer::GetWordFrequencies(int document_id) const {
-    static map<string_view, double> empty_answer;
-    if (document_to_word_freqs_.count(document_id) == 0) {
-        return empty_answer;
-    }
-
-    return (map<string_view, double>&) document_to_word_freqs_.at(document_id);
+WordFrequenciesView SearchServer::GetWordFrequencies(int document_id) const {
+    const auto [first, last] = forward_index_.Find(document_id);
+    return {term_dictionary_, first, last};
 }
 
 void SearchServer::RemoveDocument(int document_id) {
@@ -63,59 +660,89 @@ void SearchServer::RemoveDocument(std::execution::sequenced_policy, int document
     if (documents_.count(document_id) == 0) {
         return;
     }
+    InvalidateSubscriptions(document_id);
+    const DocumentData document_data = documents_.at(document_id);
+    attribute_index_.RemoveDocument(document_id, document_data.status, document_data.rating);
     documents_.erase(document_id);
-    auto& word_freq = document_to_word_freqs_.at(document_id);
-    for (auto [word, freq] : word_freq) {
-        word_to_document_freqs_[word].erase(document_id);
+    const auto [first, last] = forward_index_.Find(document_id);
+    for (auto it = first; it != last; ++it) {
+        PostingList& postings = word_to_document_freqs_[it->term_id];
+        const size_t posting_count = postings.size();
+        postings.Remove(document_id);
+        posting_stats_.OnPostingCountChanged(it->term_id, posting_count, postings.size());
+    }
+    forward_index_.RemoveDocument(document_id);
+    document_ids_.Remove(document_id);
+    if (positional_index_) {
+        positional_index_->RemoveDocument(document_id);
     }
-    document_to_word_freqs_.erase(document_id);
-    document_ids_.erase(document_id);
 }
 
 void SearchServer::RemoveDocument(execution::parallel_policy, int document_id) {
-    if (document_ids_.count(document_id) == 0) {
+    RemoveDocument(ThreadPool::GetDefault(), document_id);
+}
+
+void SearchServer::RemoveDocument(ThreadPool& pool, int document_id) {
+    if (!document_ids_.Contains(document_id)) {
         throw invalid_argument("invalid document id");
     }
 
+    InvalidateSubscriptions(document_id);
+    const DocumentData document_data = documents_.at(document_id);
+    attribute_index_.RemoveDocument(document_id, document_data.status, document_data.rating);
     documents_.erase(document_id);
 
-    map<string, double, less<>>& word_freq = document_to_word_freqs_.at(document_id);
-    vector<const string*> temp;
-    temp.reserve(word_freq.size());
-
-    for (auto iter = word_freq.begin(); iter != word_freq.end(); ++iter) {
-        temp.push_back((&iter->first));
-    }
-
-    for_each(execution::par, temp.begin(), temp.end(),  [&](const string* word){
-        word_to_document_freqs_[*word].erase(document_id);
+    const auto [first, last] = forward_index_.Find(document_id);
+    pool.ParallelFor(last - first, [&, first = first](size_t i) {
+        word_to_document_freqs_[first[i].term_id].Remove(document_id);
     });
+    for (auto it = first; it != last; ++it) {
+        const size_t posting_count = word_to_document_freqs_[it->term_id].size();
+        posting_stats_.OnPostingCountChanged(it->term_id, posting_count + 1, posting_count);
+    }
 
-    document_to_word_freqs_.erase(document_id);
+    forward_index_.RemoveDocument(document_id);
 
-    document_ids_.erase(document_id);
+    document_ids_.Remove(document_id);
+    if (positional_index_) {
+        positional_index_->RemoveDocument(document_id);
+    }
 }
 
 tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(const string_view raw_query, int document_id) const {
-    const auto query = ParseQuery(execution::seq, raw_query);
+    ThreadPool& pool = ThreadPool::GetDefault();
+    if (query_planner_.PlanMatch(SplitIntoWords(raw_query).size(), pool.GetThreadCount()) == ExecutionMode::PARALLEL) {
+        return MatchDocument(pool, raw_query, document_id);
+    }
+    return MatchDocument(execution::seq, raw_query, document_id);
+}
+
+tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(execution::sequenced_policy policy, const string_view raw_query, int document_id) const {
+    const auto query = ParseQuery(policy, raw_query);
 
     vector<string_view> matched_words;
 
     for (const auto word : query.minus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
+        const auto* document_freqs = FindWordDocumentFreqs(word);
+        if (document_freqs == nullptr) {
             continue;
         }
-        if (word_to_document_freqs_.at(word).count(document_id)) {
+        if (document_freqs->Contains(document_id)) {
             matched_words.clear();
             return {matched_words, documents_.at(document_id).status};
         }
     }
 
+    if (!MatchesQueryNode(query, query.root, document_id)) {
+        return {matched_words, documents_.at(document_id).status};
+    }
+
     for (const auto word : query.plus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
+        const auto* document_freqs = FindWordDocumentFreqs(word);
+        if (document_freqs == nullptr) {
             continue;
         }
-        if (word_to_document_freqs_.at(word).count(document_id)) {
+        if (document_freqs->Contains(document_id)) {
             matched_words.push_back(word);
         }
     }
@@ -124,33 +751,38 @@ tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(const str
     return {matched_words, documents_.at(document_id).status};
 }
 
-std::tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(std::execution::sequenced_policy policy, const std::string_view raw_query, int document_id) const {
-    return MatchDocument(raw_query, document_id);
+std::tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(std::execution::parallel_policy, const std::string_view raw_query, int document_id) const {
+    return MatchDocument(ThreadPool::GetDefault(), raw_query, document_id);
 }
 
-std::tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(std::execution::parallel_policy policy, const std::string_view raw_query, int document_id) const {
-    const Query query = ParseQuery(policy, raw_query);
+tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(ThreadPool& pool, const string_view raw_query, int document_id) const {
+    const Query query = ParseQuery(execution::seq, raw_query);
 
     vector<string_view> matched_words;
 
-    if (any_of(policy, query.minus_words.begin(), query.minus_words.end(), [this, document_id] (auto &word) {
-        return word_to_document_freqs_.count(word) != 0 && word_to_document_freqs_.at(word).count(document_id);})) {
-        matched_words.clear();
+    vector<char> is_word_in_document(query.minus_words.size(), false);
+    pool.ParallelFor(query.minus_words.size(), [&](size_t i) {
+        const auto* document_freqs = FindWordDocumentFreqs(query.minus_words[i]);
+        is_word_in_document[i] = document_freqs != nullptr && document_freqs->Contains(document_id);
+    });
+    if (any_of(is_word_in_document.begin(), is_word_in_document.end(), [](char is_found) { return is_found; })) {
         return {matched_words, documents_.at(document_id).status};
     }
 
-    matched_words.resize(query.plus_words.size());
-    auto new_end = copy_if(policy, query.plus_words.begin(), query.plus_words.end(),matched_words.begin(),
-                           [&](const auto& plus_word) {
-                               return word_to_document_freqs_.count(plus_word) != 0 && word_to_document_freqs_.at(plus_word).count(document_id);
-                           });
-
-
-    matched_words.resize(distance(matched_words.begin(), new_end));
+    if (!MatchesQueryNode(query, query.root, document_id)) {
+        return {matched_words, documents_.at(document_id).status};
+    }
 
-    sort(policy, matched_words.begin(), matched_words.end());
-    new_end = unique(policy, matched_words.begin(), matched_words.end());
-    matched_words.resize(distance(matched_words.begin(), new_end));
+    is_word_in_document.assign(query.plus_words.size(), false);
+    pool.ParallelFor(query.plus_words.size(), [&](size_t i) {
+        const auto* document_freqs = FindWordDocumentFreqs(query.plus_words[i]);
+        is_word_in_document[i] = document_freqs != nullptr && document_freqs->Contains(document_id);
+    });
+    for (size_t i = 0; i < query.plus_words.size(); ++i) {
+        if (is_word_in_document[i]) {
+            matched_words.push_back(query.plus_words[i]);
+        }
+    }
 
     return {matched_words, documents_.at(document_id).status};
 }
@@ -165,9 +797,15 @@ bool SearchServer::IsValidWord(const string_view word) {
     });
 }
 
-vector<string_view> SearchServer::SplitIntoWordsNoStop(const string_view text) const {
+vector<string_view> SearchServer::SplitIntoWordsNoStop(const string_view text, deque<string>& normalized_words) const {
+    vector<string_view> tokens;
+    if (text_normalizer_.IsEnabled()) {
+        text_normalizer_.Tokenize(text, normalized_words, tokens);
+    } else {
+        tokens = SplitIntoWords(text);
+    }
     vector<string_view> words;
-    for (const string_view word : SplitIntoWords(text)) {
+    for (const string_view word : tokens) {
         if (!IsValidWord(word)) {
             throw invalid_argument("Word "s + string{word} + " is invalid"s);
         }
@@ -191,34 +829,260 @@ SearchServer::QueryWord SearchServer::ParseQueryWord(string_view text) const {
         throw invalid_argument("Query word is empty"s);
     }
     bool is_minus = false;
+    bool is_required = false;
     if (text[0] == '-') {
         is_minus = true;
         text = text.substr(1);
+    } else if (text[0] == '+') {
+        is_required = true;
+        text = text.substr(1);
+    }
+    bool is_prefix = false;
+    if (!text.empty() && text.back() == '*') {
+        is_prefix = true;
+        text = text.substr(0, text.size() - 1);
     }
-    if (text.empty() || text[0] == '-' || !IsValidWord(text)) {
+    if (text.empty() || text[0] == '-' || text[0] == '+' || !IsValidWord(text)) {
         throw invalid_argument("Query word "s + string{text} + " is invalid");
     }
 
-    return {text, is_minus, IsStopWord(text)};
+    return {text, is_minus, is_required, is_prefix};
+}
+
+vector<string_view> SearchServer::NormalizeQueryWord(const string_view word, Query& result) const {
+    if (!text_normalizer_.IsEnabled()) {
+        return {word};
+    }
+    vector<string_view> tokens;
+    text_normalizer_.Tokenize(word, result.normalized_words, tokens);
+    for (string_view& token : tokens) {
+        const int term_id = term_dictionary_.Find(token);
+        if (term_id >= 0) {
+            token = term_dictionary_.GetTerm(term_id);
+        }
+    }
+    return tokens;
 }
 
 SearchServer::Query SearchServer::ParseQuery(const std::string_view text) const {
     return ParseQuery(std::execution::seq, text);
 }
 
-
-SearchServer::Query SearchServer::ParseQuery(std::execution::sequenced_policy policy, const string_view text) const {
-    Query result;
-    for (const auto word: SplitIntoWords(text)) {
-        const auto query_word = ParseQueryWord(word);
-        if (!query_word.is_stop) {
-            if (query_word.is_minus) {
-                result.minus_words.push_back(query_word.data);
+vector<SearchServer::QueryToken> SearchServer::TokenizeQuery(const string_view text) {
+    vector<QueryToken> tokens;
+    for (string_view word : SplitIntoWords(text)) {
+        while (!word.empty()) {
+            if (word[0] == '(') {
+                tokens.push_back({QueryToken::Type::OPEN, Occur::SHOULD, {}});
+                word.remove_prefix(1);
+            } else if (word.size() > 1 && (word[0] == '+' || word[0] == '-') && word[1] == '(') {
+                tokens.push_back({QueryToken::Type::OPEN, word[0] == '+' ? Occur::MUST : Occur::MUST_NOT, {}});
+                word.remove_prefix(2);
             } else {
-                result.plus_words.push_back(query_word.data);
+                break;
             }
         }
+        size_t close_count = 0;
+        while (!word.empty() && word.back() == ')') {
+            ++close_count;
+            word.remove_suffix(1);
+        }
+        if (!word.empty()) {
+            tokens.push_back({QueryToken::Type::WORD, Occur::SHOULD, word});
+        }
+        for (size_t i = 0; i < close_count; ++i) {
+            tokens.push_back({QueryToken::Type::CLOSE, Occur::SHOULD, {}});
+        }
     }
+    return tokens;
+}
+
+void SearchServer::ParseQueryTree(const string_view text, Query& result) const {
+    const auto tokens = TokenizeQuery(text);
+    const size_t end = ParseQueryGroup(tokens, 0, result.root, false, result);
+    if (end != tokens.size()) {
+        throw invalid_argument("Unbalanced parentheses in query"s);
+    }
+    result.is_boolean = any_of(result.root.children.begin(), result.root.children.end(), [](const QueryNode& node) {
+        return node.occur == Occur::MUST || node.word.empty();
+    });
+}
+
+size_t SearchServer::ParseQueryGroup(const vector<QueryToken>& tokens, size_t pos, QueryNode& group, bool is_excluded, Query& result) const {
+    const bool is_root = &group == &result.root;
+    while (pos < tokens.size()) {
+        const QueryToken& token = tokens[pos];
+        if (token.type == QueryToken::Type::CLOSE) {
+            if (is_root) {
+                return pos;
+            }
+            return pos + 1;
+        }
+        if (token.type == QueryToken::Type::OPEN) {
+            QueryNode child;
+            child.occur = token.occur;
+            pos = ParseQueryGroup(tokens, pos + 1, child, is_excluded || child.occur == Occur::MUST_NOT, result);
+            if (!child.children.empty()) {
+                group.children.push_back(move(child));
+            }
+            continue;
+        }
+
+        const string_view text = token.text;
+        const size_t sign_length = (text[0] == '+' || text[0] == '-') ? 1 : 0;
+        if (text.size() > sign_length && text[sign_length] == '"') {
+            pos = ParseQueryPhrase(tokens, pos, group, is_excluded, result);
+            continue;
+        }
+
+        const auto query_word = ParseQueryWord(text);
+        const Occur occur = query_word.is_minus ? Occur::MUST_NOT : (query_word.is_required ? Occur::MUST : Occur::SHOULD);
+        for (const string_view normalized_word : NormalizeQueryWord(query_word.data, result)) {
+            if (query_word.is_prefix) {
+                const auto expansions = ExpandPrefix(normalized_word, result.statistics);
+                if (occur == Occur::MUST) {
+                    QueryNode child;
+                    child.occur = Occur::MUST;
+                    for (const string_view word : expansions) {
+                        AddQueryTerm(child, Occur::SHOULD, word, is_excluded, result);
+                    }
+                    group.children.push_back(move(child));
+                } else {
+                    for (const string_view word : expansions) {
+                        AddQueryTerm(group, occur, word, is_excluded, result);
+                    }
+                }
+            } else if (!IsStopWord(normalized_word)) {
+                AddQueryTerm(group, occur, normalized_word, is_excluded, result);
+            }
+        }
+        ++pos;
+    }
+    if (!is_root) {
+        throw invalid_argument("Unbalanced parentheses in query"s);
+    }
+    return pos;
+}
+
+void SearchServer::AddQueryTerm(QueryNode& group, Occur occur, string_view word, bool is_excluded, Query& result) const {
+    QueryNode node;
+    node.occur = occur;
+    node.word = word;
+    group.children.push_back(node);
+    if (occur == Occur::MUST_NOT) {
+        if (&group == &result.root) {
+            result.minus_words.push_back(word);
+        }
+    } else if (!is_excluded) {
+        result.plus_words.push_back(word);
+    }
+}
+
+size_t SearchServer::ParseQueryPhrase(const vector<QueryToken>& tokens, size_t first, QueryNode& group, bool is_excluded, Query& result) const {
+    Occur occur = Occur::MUST;
+    vector<string_view> words_in_phrase;
+    for (size_t i = first; i < tokens.size() && tokens[i].type == QueryToken::Type::WORD; ++i) {
+        string_view word = tokens[i].text;
+        if (i == first) {
+            if (word[0] == '-') {
+                occur = Occur::MUST_NOT;
+                word.remove_prefix(1);
+            } else if (word[0] == '+') {
+                word.remove_prefix(1);
+            }
+            word.remove_prefix(1);
+        }
+        const size_t quote = word.find('"');
+        string_view suffix;
+        if (quote != string_view::npos) {
+            suffix = word.substr(quote + 1);
+            word = word.substr(0, quote);
+        }
+        if (!word.empty()) {
+            if (!IsValidWord(word)) {
+                throw invalid_argument("Query word "s + string{word} + " is invalid");
+            }
+            for (const string_view normalized_word : NormalizeQueryWord(word, result)) {
+                if (!IsStopWord(normalized_word)) {
+                    words_in_phrase.push_back(normalized_word);
+                }
+            }
+        }
+        if (quote == string_view::npos) {
+            continue;
+        }
+
+        QueryPhrase phrase;
+        phrase.slop = ParsePhraseSlop(suffix);
+        if (words_in_phrase.size() == 1) {
+            AddQueryTerm(group, occur, words_in_phrase[0], is_excluded, result);
+        } else if (words_in_phrase.size() > 1) {
+            if (!positional_index_) {
+                throw invalid_argument("Phrase queries require positional index"s);
+            }
+            phrase.is_scored = occur != Occur::MUST_NOT && !is_excluded;
+            for (const string_view word : words_in_phrase) {
+                phrase.words.push_back(word);
+                phrase.term_ids.push_back(term_dictionary_.Find(word));
+                if (occur != Occur::MUST_NOT && !is_excluded) {
+                    result.plus_words.push_back(word);
+                }
+            }
+            QueryNode node;
+            node.occur = occur;
+            node.phrase = result.phrases.size();
+            group.children.push_back(node);
+            result.phrases.push_back(move(phrase));
+        }
+        return i + 1;
+    }
+    throw invalid_argument("Phrase is not closed"s);
+}
+
+int SearchServer::ParsePhraseSlop(string_view text) {
+    if (text.empty()) {
+        return 0;
+    }
+    int slop = 0;
+    if (text[0] != '~' || text.size() == 1) {
+        throw invalid_argument("Phrase suffix "s + string{text} + " is invalid");
+    }
+    const auto [end, error] = from_chars(text.data() + 1, text.data() + text.size(), slop);
+    if (error != errc() || end != text.data() + text.size() || slop < 0) {
+        throw invalid_argument("Phrase suffix "s + string{text} + " is invalid");
+    }
+    return slop;
+}
+
+vector<string_view> SearchServer::ExpandPrefix(string_view prefix, const CorpusStatistics* statistics) const {
+    vector<string_view> words;
+    if (statistics != nullptr) {
+        const auto& document_freqs = statistics->document_freqs;
+        for (auto it = document_freqs.lower_bound(prefix); it != document_freqs.end() && string_view(it->first).substr(0, prefix.size()) == prefix; ++it) {
+            if (it->second == 0) {
+                continue;
+            }
+            words.push_back(it->first);
+            if (static_cast<int>(words.size()) == MAX_PREFIX_EXPANSIONS) {
+                break;
+            }
+        }
+        return words;
+    }
+    term_dictionary_.ForEachTermWithPrefix(prefix, [&](int term_id) {
+        if (word_to_document_freqs_[term_id].empty()) {
+            return true;
+        }
+        words.push_back(term_dictionary_.GetTerm(term_id));
+        return static_cast<int>(words.size()) < MAX_PREFIX_EXPANSIONS;
+    });
+    return words;
+}
+
+SearchServer::Query SearchServer::ParseQuery(std::execution::sequenced_policy, const string_view text, const CorpusStatistics* statistics) const {
+    Query result;
+    result.statistics = statistics;
+    ParseQueryTree(text, result);
     sort(result.plus_words.begin(), result.plus_words.end());
     result.plus_words.erase(unique(result.plus_words.begin(), result.plus_words.end()), result.plus_words.end());
 
@@ -228,23 +1092,360 @@ SearchServer::Query SearchServer::ParseQuery(std::execution::sequenced_policy po
     return result;
 }
 
-SearchServer::Query SearchServer::ParseQuery(std::execution::parallel_policy policy, const string_view text) const {
-    Query result;
-    for (const auto word : SplitIntoWords(text)) {
-        const auto query_word = ParseQueryWord(word);
-        if (!query_word.is_stop) {
-            if (query_word.is_minus) {
-                result.minus_words.push_back(query_word.data);
-            } else {
-                result.plus_words.push_back(query_word.data);
+void SearchServer::ResolveQueryPhrases(Query& query) const {
+    for (QueryPhrase& phrase : query.phrases) {
+        for (size_t i = 0; i < phrase.words.size(); ++i) {
+            if (phrase.term_ids[i] < 0) {
+                phrase.term_ids[i] = term_dictionary_.Find(phrase.words[i]);
+            }
+        }
+    }
+}
+
+const PostingList* SearchServer::FindWordDocumentFreqs(const string_view word) const {
+    const int term_id = term_dictionary_.Find(word);
+    if (term_id < 0 || word_to_document_freqs_[term_id].empty()) {
+        return nullptr;
+    }
+    return &word_to_document_freqs_[term_id];
+}
+
+double SearchServer::ComputeWordInverseDocumentFreq(const Query& query, const string_view word, size_t document_freq) const {
+    if (query.statistics == nullptr) {
+        return log(GetDocumentCount() * 1.0 / document_freq);
+    }
+    const auto it = query.statistics->document_freqs.find(word);
+    if (it != query.statistics->document_freqs.end() && it->second > 0) {
+        document_freq = it->second;
+    }
+    return log(query.statistics->document_count * 1.0 / document_freq);
+}
+
+pmr::vector<WeightedPostingList> SearchServer::GetWeightedPostingLists(const Query& query, pmr::memory_resource* resource) const {
+    pmr::vector<WeightedPostingList> terms(resource);
+    terms.reserve(query.plus_words.size());
+    for (const string_view word : query.plus_words) {
+        const auto* document_freqs = FindWordDocumentFreqs(word);
+        if (document_freqs != nullptr && !document_freqs->empty()) {
+            terms.push_back({document_freqs, ComputeWordInverseDocumentFreq(query, word, document_freqs->size())});
+        }
+    }
+    return terms;
+}
+
+vector<int> SearchServer::FindPhraseDocuments(const QueryPhrase& phrase) const {
+    vector<const PostingList*> postings;
+    for (const int term_id : phrase.term_ids) {
+        if (term_id < 0 || word_to_document_freqs_[term_id].empty()) {
+            return {};
+        }
+        postings.push_back(&word_to_document_freqs_[term_id]);
+    }
+    sort(postings.begin(), postings.end(), [](const auto* lhs, const auto* rhs) {
+        return make_pair(lhs->size(), lhs) < make_pair(rhs->size(), rhs);
+    });
+    postings.erase(unique(postings.begin(), postings.end()), postings.end());
+
+    const auto& first_document_ids = postings.front()->GetDocumentIds();
+    vector<int> candidates(first_document_ids.begin(), first_document_ids.end());
+    for (auto it = next(postings.begin()); it != postings.end() && !candidates.empty(); ++it) {
+        candidates = IntersectSorted(candidates, (*it)->GetDocumentIds());
+    }
+
+    vector<int> result;
+    for (const int document_id : candidates) {
+        if (positional_index_->ContainsPhrase(document_id, phrase.term_ids, phrase.slop)) {
+            result.push_back(document_id);
+        }
+    }
+    return result;
+}
+
+bool SearchServer::MatchesQueryNode(const Query& query, const QueryNode& node, int document_id) const {
+    if (!node.word.empty()) {
+        const auto* document_freqs = FindWordDocumentFreqs(node.word);
+        return document_freqs != nullptr && document_freqs->Contains(document_id);
+    }
+    if (node.phrase >= 0) {
+        const QueryPhrase& phrase = query.phrases[node.phrase];
+        return positional_index_->ContainsPhrase(document_id, phrase.term_ids, phrase.slop);
+    }
+
+    bool has_required = false;
+    bool has_optional_match = false;
+    for (const QueryNode& child : node.children) {
+        const bool matches = MatchesQueryNode(query, child, document_id);
+        if (child.occur == Occur::MUST) {
+            if (!matches) {
+                return false;
+            }
+            has_required = true;
+        } else if (child.occur == Occur::MUST_NOT) {
+            if (matches) {
+                return false;
             }
+        } else {
+            has_optional_match = has_optional_match || matches;
         }
     }
+    return has_required || has_optional_match;
+}
+
+size_t SearchServer::EstimateQueryNodeCost(const Query& query, const QueryNode& node) const {
+    if (!node.word.empty()) {
+        const auto* document_freqs = FindWordDocumentFreqs(node.word);
+        return document_freqs == nullptr ? 0 : document_freqs->size();
+    }
+    if (node.phrase >= 0) {
+        size_t cost = numeric_limits<size_t>::max();
+        for (const int term_id : query.phrases[node.phrase].term_ids) {
+            cost = min(cost, term_id < 0 ? 0 : word_to_document_freqs_[term_id].size());
+        }
+        return cost;
+    }
+
+    size_t required_cost = numeric_limits<size_t>::max();
+    size_t optional_cost = 0;
+    for (const QueryNode& child : node.children) {
+        if (child.occur == Occur::MUST) {
+            required_cost = min(required_cost, EstimateQueryNodeCost(query, child));
+        } else if (child.occur == Occur::SHOULD) {
+            optional_cost += EstimateQueryNodeCost(query, child);
+        }
+    }
+    return required_cost != numeric_limits<size_t>::max() ? required_cost : optional_cost;
+}
+
+const pmr::vector<int>& SearchServer::GetQueryNodeDocuments(const Query& query, const QueryNode& node, pmr::vector<int>& storage) const {
+    if (!node.word.empty()) {
+        const auto* document_freqs = FindWordDocumentFreqs(node.word);
+        if (document_freqs != nullptr) {
+            return document_freqs->GetDocumentIds();
+        }
+        storage.clear();
+        return storage;
+    }
+    const vector<int> document_ids = EvaluateQueryNode(query, node);
+    storage.assign(document_ids.begin(), document_ids.end());
+    return storage;
+}
+
+vector<int> SearchServer::EvaluateQueryNode(const Query& query, const QueryNode& node) const {
+    if (!node.word.empty()) {
+        pmr::vector<int> storage;
+        const auto& document_ids = GetQueryNodeDocuments(query, node, storage);
+        return vector<int>(document_ids.begin(), document_ids.end());
+    }
+    if (node.phrase >= 0) {
+        return FindPhraseDocuments(query.phrases[node.phrase]);
+    }
+
+    vector<pair<size_t, const QueryNode*>> required;
+    vector<const QueryNode*> optional;
+    vector<const QueryNode*> excluded;
+    for (const QueryNode& child : node.children) {
+        if (child.occur == Occur::MUST) {
+            required.emplace_back(EstimateQueryNodeCost(query, child), &child);
+        } else if (child.occur == Occur::SHOULD) {
+            optional.push_back(&child);
+        } else {
+            excluded.push_back(&child);
+        }
+    }
+
+    vector<int> result;
+    pmr::vector<int> storage;
+    if (!required.empty()) {
+        sort(required.begin(), required.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs.first < rhs.first;
+        });
+        result = EvaluateQueryNode(query, *required.front().second);
+        for (size_t i = 1; i < required.size() && !result.empty(); ++i) {
+            result = IntersectSorted(result, GetQueryNodeDocuments(query, *required[i].second, storage));
+        }
+    } else {
+        for (const QueryNode* child : optional) {
+            result = UniteSorted(result, GetQueryNodeDocuments(query, *child, storage));
+        }
+    }
+
+    for (size_t i = 0; i < excluded.size() && !result.empty(); ++i) {
+        result = SubtractSorted(result, GetQueryNodeDocuments(query, *excluded[i], storage));
+    }
     return result;
 }
 
-double SearchServer::ComputeWordInverseDocumentFreq(const string_view word) const {
-    return log(GetDocumentCount() * 1.0 / word_to_document_freqs_.at(word).size());
+double SearchServer::ComputeProximityBoost(const Query& query, int document_id) const {
+    double boost = 1.0;
+    for (const QueryPhrase& phrase : query.phrases) {
+        if (!phrase.is_scored) {
+            continue;
+        }
+        const int span = positional_index_->FindShortestPhraseSpan(document_id, phrase.term_ids, phrase.slop);
+        if (span > 0) {
+            boost += PHRASE_PROXIMITY_BOOST * (phrase.term_ids.size() - 1) / span;
+        }
+    }
+    return boost;
 }
 
+pmr::vector<double> SearchServer::ComputeRelevances(const vector<int>& document_ids, const Query& query, pmr::vector<bool>& is_matched) const {
+    pmr::vector<double> relevances(document_ids.size(), 0.0, is_matched.get_allocator().resource());
+    is_matched.assign(document_ids.size(), false);
+    if (document_ids.empty()) {
+        return relevances;
+    }
+    for (const string_view word : query.plus_words) {
+        const auto* document_freqs = FindWordDocumentFreqs(word);
+        if (document_freqs == nullptr) {
+            continue;
+        }
+        const double inverse_document_freq = ComputeWordInverseDocumentFreq(query, word, document_freqs->size());
+        const auto& posting_ids = document_freqs->GetDocumentIds();
+        const auto& term_freqs = document_freqs->GetTermFreqs();
+        size_t cursor = 0;
+        for (size_t i = 0; i < document_ids.size(); ++i) {
+            cursor = GallopLowerBound(posting_ids, cursor, document_ids[i]);
+            if (cursor == posting_ids.size()) {
+                break;
+            }
+            if (posting_ids[cursor] == document_ids[i]) {
+                relevances[i] += term_freqs[cursor] * inverse_document_freq;
+                is_matched[i] = true;
+            }
+        }
+    }
+    if (!query.phrases.empty()) {
+        for (size_t i = 0; i < document_ids.size(); ++i) {
+            relevances[i] *= ComputeProximityBoost(query, document_ids[i]);
+        }
+    }
+    return relevances;
+}
+
+RoaringBitmap SearchServer::CollectExcludedDocuments(const Query& query) const {
+    RoaringBitmap excluded_documents;
+    for (const string_view word : query.minus_words) {
+        const auto* document_freqs = FindWordDocumentFreqs(word);
+        if (document_freqs == nullptr) {
+            continue;
+        }
+        for (const int document_id : document_freqs->GetDocumentIds()) {
+            excluded_documents.Add(document_id);
+        }
+    }
+    return excluded_documents;
+}
+
+int64_t SearchServer::QuantizeRelevance(double relevance) {
+    return llround(relevance / MAX_REL_INNACURACY);
+}
+
+bool SearchServer::IsRankedHigher(const Document& lhs, const Document& rhs) {
+    const int64_t lhs_relevance = QuantizeRelevance(lhs.relevance);
+    const int64_t rhs_relevance = QuantizeRelevance(rhs.relevance);
+    if (lhs_relevance == rhs_relevance) {
+        if (lhs.rating == rhs.rating) {
+            return lhs.id < rhs.id;
+        }
+        return lhs.rating > rhs.rating;
+    }
+    return lhs_relevance > rhs_relevance;
+}
+
+DocumentPage SearchServer::SelectPage(vector<Document> matched_documents, size_t offset, size_t limit) {
+    if (limit == 0) {
+        throw invalid_argument("Page limit must be positive"s);
+    }
+    const size_t first = min(offset, matched_documents.size());
+    const size_t last = first + min(limit, matched_documents.size() - first);
+    if (last < matched_documents.size()) {
+        nth_element(matched_documents.begin(), matched_documents.begin() + last, matched_documents.end(), IsRankedHigher);
+    }
+    sort(matched_documents.begin(), matched_documents.begin() + last, IsRankedHigher);
+
+    DocumentPage page;
+    page.documents.assign(matched_documents.begin() + first, matched_documents.begin() + last);
+    if (first < last && last < matched_documents.size()) {
+        const Document& last_document = matched_documents[last - 1];
+        page.next_cursor = PageCursor{last_document.relevance, last_document.rating, last_document.id};
+    }
+    return page;
+}
 
+void SearchServer::SortTopDocuments(execution::sequenced_policy, vector<Document>& matched_documents) {
+    sort(matched_documents.begin(), matched_documents.end(), IsRankedHigher);
+    if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
+        matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+    }
+}
+
+void SearchServer::AddRankedDocument(vector<Document>& ranked_documents, size_t document_limit, const Document& document) {
+    if (document_limit == numeric_limits<size_t>::max()) {
+        ranked_documents.push_back(document);
+        return;
+    }
+    if (ranked_documents.size() == document_limit) {
+        if (!IsRankedHigher(document, ranked_documents.front())) {
+            return;
+        }
+        pop_heap(ranked_documents.begin(), ranked_documents.end(), IsRankedHigher);
+        ranked_documents.pop_back();
+    }
+    ranked_documents.push_back(document);
+    push_heap(ranked_documents.begin(), ranked_documents.end(), IsRankedHigher);
+}
+
+double SearchServer::GetRankedScoreThreshold(const vector<Document>& ranked_documents, size_t document_limit) {
+    if (ranked_documents.size() < document_limit) {
+        return -numeric_limits<double>::infinity();
+    }
+    return ranked_documents.front().relevance - 2 * MAX_REL_INNACURACY;
+}
+
+QueryStats SearchServer::PlanFilteredQuery(const Query& query, RoaringBitmap& allowed_documents, size_t thread_count) const {
+    QueryStats stats;
+    stats.term_count = query.plus_words.size();
+    stats.posting_count = CountQueryPostings(query);
+    if (!query.is_boolean) {
+        const RoaringBitmap excluded_documents = CollectExcludedDocuments(query);
+        stats.excluded_count = excluded_documents.Count();
+        allowed_documents -= excluded_documents;
+    }
+    stats.candidate_count = allowed_documents.Count();
+    query_planner_.Plan(stats, true, thread_count);
+    return stats;
+}
+
+size_t SearchServer::CountQueryPostings(const Query& query) const {
+    size_t posting_count = 0;
+    for (const string_view word : query.plus_words) {
+        const auto* document_freqs = FindWordDocumentFreqs(word);
+        if (document_freqs != nullptr) {
+            posting_count += document_freqs->size();
+        }
+    }
+    return posting_count;
+}
+
+vector<Document> SearchServer::FindDocumentsInSet(const Query& query, vector<int> candidates) const {
+    vector<int> document_ids;
+    if (query.is_boolean) {
+        document_ids = IntersectSorted(EvaluateQueryNode(query, query.root), candidates);
+    } else {
+        document_ids = move(candidates);
+    }
+
+    ScratchArena scratch;
+    pmr::vector<bool> is_matched(scratch.GetResource());
+    const auto relevances = ComputeRelevances(document_ids, query, is_matched);
+
+    vector<Document> matched_documents;
+    matched_documents.reserve(document_ids.size());
+    for (size_t i = 0; i < document_ids.size(); ++i) {
+        if (query.is_boolean || is_matched[i]) {
+            matched_documents.push_back({ document_ids[i], relevances[i], documents_.at(document_ids[i]).rating });
+        }
+    }
+    return matched_documents;
+}
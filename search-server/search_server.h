@@ -3,16 +3,48 @@
 #include <map>
 #include <tuple>
 #include <algorithm>
+#include <cstdint>
+#include <deque>
 #include <execution>
+#include <functional>
 #include <set>
 #include <string_view>
+#include <optional>
+#include <memory_resource>
 #include "string_processing.h"
 #include "document.h"
+#include "attribute_index.h"
 #include "log_duration.h"
-#include "concurrent_map.h"
+#include "forward_index.h"
+#include "index_stats.h"
+#include "positional_index.h"
+#include "posting_list.h"
+#include "query_planner.h"
+#include "roaring_bitmap.h"
+#include "scratch_arena.h"
+#include "score_accumulator.h"
+#include "subscription_index.h"
+#include "term_dictionary.h"
+#include "text_normalizer.h"
+#include "thread_pool.h"
 
 const int MAX_RESULT_DOCUMENT_COUNT = 5;
 const double MAX_REL_INNACURACY = 1e-6;
+const int MAX_PREFIX_EXPANSIONS = 64;
+const double PHRASE_PROXIMITY_BOOST = 0.5;
+
+struct PreparedDocument {
+    int id = 0;
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    int rating = 0;
+    std::vector<std::string_view> words;
+    std::deque<std::string> normalized_words;
+};
+
+struct CorpusStatistics {
+    int document_count = 0;
+    std::map<std::string, size_t, std::less<>> document_freqs;
+};
 
 class SearchServer {
 public:
@@ -23,16 +55,32 @@ public:
     template <typename StringContainer>
     explicit SearchServer(const StringContainer& stop_words);
 
+    void EnablePositionalIndex();
+
+    void SetTextNormalization(const NormalizationOptions& options);
+
     void AddDocument(int document_id, const std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+
+    PreparedDocument PrepareDocument(int document_id, const std::string_view document, DocumentStatus status, const std::vector<int>& ratings) const;
+
+    void AddPreparedDocument(const PreparedDocument& document);
+
     std::vector<Document> FindTopDocuments(const std::string_view& raw_query) const;
 
     std::vector<Document> FindTopDocuments(const std::string_view& raw_query, DocumentStatus status) const;
 
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query, const DocumentFilter& filter) const;
+
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query, const DocumentFilter& filter, QueryStats& stats) const;
+
     template <typename DocumentPredicate>
     std::vector<Document> FindTopDocuments(const std::string_view raw_query, DocumentPredicate document_predicate) const;
 
-    template <typename ExecutionPolicy>
-    std::vector<Document> FindTopDocuments(ExecutionPolicy policy, const std::string_view raw_query, DocumentStatus status) const;
+    std::vector<Document> FindTopDocuments(std::execution::sequenced_policy policy, const std::string_view raw_query, DocumentStatus status) const;
+    std::vector<Document> FindTopDocuments(std::execution::parallel_policy policy, const std::string_view raw_query, DocumentStatus status) const;
+
+    std::vector<Document> FindTopDocuments(std::execution::sequenced_policy policy, const std::string_view raw_query, const DocumentFilter& filter) const;
+    std::vector<Document> FindTopDocuments(std::execution::parallel_policy policy, const std::string_view raw_query, const DocumentFilter& filter) const;
 
     template <typename ExecutionPolicy>
     std::vector<Document> FindTopDocuments(ExecutionPolicy policy, const std::string_view raw_query) const;
@@ -43,68 +91,255 @@ public:
     template <typename DocumentPredicate>
     std::vector<Document> FindTopDocuments(std::execution::sequenced_policy policy, const std::string_view raw_query, DocumentPredicate document_predicate) const;
 
+    std::vector<Document> FindTopDocuments(ThreadPool& pool, const std::string_view raw_query) const;
+    std::vector<Document> FindTopDocuments(ThreadPool& pool, const std::string_view raw_query, DocumentStatus status) const;
+    std::vector<Document> FindTopDocuments(ThreadPool& pool, const std::string_view raw_query, const DocumentFilter& filter) const;
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(ThreadPool& pool, const std::string_view raw_query, DocumentPredicate document_predicate) const;
+
+    DocumentPage FindTopDocumentsPage(const std::string_view raw_query, size_t offset, size_t limit) const;
+    DocumentPage FindTopDocumentsPage(const std::string_view raw_query, const PageCursor& after, size_t limit) const;
+    DocumentPage FindTopDocumentsPage(const std::string_view raw_query, const DocumentFilter& filter, size_t offset, size_t limit) const;
+    DocumentPage FindTopDocumentsPage(const std::string_view raw_query, const DocumentFilter& filter, const PageCursor& after, size_t limit) const;
+
+    std::vector<std::vector<Document>> FindTopDocumentsBatch(const std::vector<std::string>& raw_queries, DocumentStatus status) const;
+    std::vector<std::vector<Document>> FindTopDocumentsBatch(ThreadPool& pool, const std::vector<std::string>& raw_queries, DocumentStatus status) const;
+
+    IndexStats GetIndexStats() const;
+
+    static bool IsRankedHigher(const Document& lhs, const Document& rhs);
+
+    int AddSubscription(const std::string_view raw_query, DocumentStatus status);
+
+    void RemoveSubscription(int subscription_id);
+
+    // Between refreshes new documents are scored with the current IDF while kept ones keep their old scores,
+    // so the order of the top is approximate until the subscription is re-evaluated.
+    const std::vector<Document>& GetSubscriptionTopDocuments(int subscription_id);
+
+    std::vector<int> TakeUpdatedSubscriptions();
+
+    void SetSubscriptionRefreshInterval(size_t document_count);
+
+    void SetQueryPlannerThresholds(const QueryPlannerThresholds& thresholds);
+
+    const QueryPlannerThresholds& GetQueryPlannerThresholds() const;
+
+    QueryPlannerThresholds CalibrateQueryPlanner(const std::vector<std::string>& sample_queries);
+
     int GetDocumentCount() const;
 
     //int GetDocumentId(int index) const;
 
-    std::set<int>::const_iterator  begin() const;
-    std::set<int>::const_iterator end() const;
+    RoaringBitmap::const_iterator begin() const;
+    RoaringBitmap::const_iterator end() const;
 
-    const std::map<std::string_view, double>& GetWordFrequencies(int document_id) const;
+    // The view points into the forward index: AddDocument and RemoveDocument (which may compact it) invalidate it.
+    // Words are listed in term-id order, not lexicographically.
+    WordFrequenciesView GetWordFrequencies(int document_id) const;
+
+    template <typename Visitor>
+    void ForEachDocument(Visitor visitor) const;
 
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::string_view raw_query, int document_id) const;
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::execution::parallel_policy policy, const std::string_view raw_query, int document_id) const;
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::execution::sequenced_policy policy, const std::string_view raw_query, int document_id) const;
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(ThreadPool& pool, const std::string_view raw_query, int document_id) const;
 
     void RemoveDocument(int document_id);
     void RemoveDocument(std::execution::sequenced_policy, int document_id);
     void RemoveDocument(std::execution::parallel_policy, int document_id);
+    void RemoveDocument(ThreadPool& pool, int document_id);
 private:
+    friend class LocalShardTransport;
+
+    CorpusStatistics CollectStatistics(const std::string_view raw_query) const;
+
+    std::vector<Document> FindTopDocuments(std::execution::sequenced_policy policy, const std::string_view raw_query, const DocumentFilter& filter, const CorpusStatistics& statistics) const;
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(std::execution::sequenced_policy policy, const std::string_view raw_query, DocumentPredicate document_predicate, const CorpusStatistics& statistics) const;
+
     struct DocumentData {
         int rating;
         DocumentStatus status;
     };
 
-    const std::set<std::string, std::less<>> stop_words_;
+    std::set<std::string, std::less<>> stop_words_;
+    TextNormalizer text_normalizer_;
+
+    std::pmr::unsynchronized_pool_resource index_memory_;
+
+    TermDictionary term_dictionary_;
+    std::vector<PostingList> word_to_document_freqs_;
+    ForwardIndex forward_index_{&index_memory_};
 
-    std::map<std::string_view, std::map<int, double>> word_to_document_freqs_;
-    std::map<int, std::map<std::string, double, std::less<>>> document_to_word_freqs_;
+    std::pmr::map<int, DocumentData> documents_{&index_memory_};
+    RoaringBitmap document_ids_;
+    AttributeIndex attribute_index_;
 
-    std::map<int, DocumentData> documents_;
-    std::set<int> document_ids_;
+    std::optional<PositionalIndex> positional_index_;
+
+    QueryPlanner query_planner_;
+    PostingStatsTracker posting_stats_;
 
     bool IsStopWord(const std::string_view word) const;
 
     static bool IsValidWord(const std::string_view word);
 
-    std::vector<std::string_view> SplitIntoWordsNoStop(const std::string_view text) const;
+    std::vector<std::string_view> SplitIntoWordsNoStop(const std::string_view text, std::deque<std::string>& normalized_words) const;
 
     static int ComputeAverageRating(const std::vector<int>& ratings);
 
     struct QueryWord {
         std::string_view data;
         bool is_minus;
-        bool is_stop;
+        bool is_required;
+        bool is_prefix;
     };
 
     QueryWord ParseQueryWord(std::string_view text) const;
 
+    struct QueryPhrase {
+        std::vector<std::string_view> words;
+        std::vector<int> term_ids;
+        int slop = 0;
+        bool is_scored = false;
+    };
+
+    enum class Occur {
+        SHOULD,
+        MUST,
+        MUST_NOT,
+    };
+
+    struct QueryNode {
+        Occur occur = Occur::SHOULD;
+        std::string_view word;
+        int phrase = -1;
+        std::vector<QueryNode> children;
+    };
+
+    struct QueryToken {
+        enum class Type {
+            WORD,
+            OPEN,
+            CLOSE,
+        };
+
+        Type type;
+        Occur occur;
+        std::string_view text;
+    };
+
     struct Query {
         std::vector<std::string_view> plus_words;
         std::vector<std::string_view> minus_words;
+        std::vector<QueryPhrase> phrases;
+        QueryNode root;
+        bool is_boolean = false;
+        const CorpusStatistics* statistics = nullptr;
+        std::deque<std::string> normalized_words;
     };
 
+    std::vector<std::string_view> NormalizeQueryWord(std::string_view word, Query& result) const;
+
+    static std::vector<QueryToken> TokenizeQuery(const std::string_view text);
+    size_t ParseQueryGroup(const std::vector<QueryToken>& tokens, size_t pos, QueryNode& group, bool is_excluded, Query& result) const;
+    size_t ParseQueryPhrase(const std::vector<QueryToken>& tokens, size_t first, QueryNode& group, bool is_excluded, Query& result) const;
+    void AddQueryTerm(QueryNode& group, Occur occur, std::string_view word, bool is_excluded, Query& result) const;
+    static int ParsePhraseSlop(std::string_view text);
+    std::vector<std::string_view> ExpandPrefix(std::string_view prefix, const CorpusStatistics* statistics) const;
+    void ParseQueryTree(const std::string_view text, Query& result) const;
+
     Query ParseQuery(const std::string_view text) const;
-    Query ParseQuery(std::execution::parallel_policy policy, const std::string_view text) const;
-    Query ParseQuery(std::execution::sequenced_policy policy, const std::string_view text) const;
+    Query ParseQuery(std::execution::sequenced_policy policy, const std::string_view text, const CorpusStatistics* statistics = nullptr) const;
+    void ResolveQueryPhrases(Query& query) const;
 
-    double ComputeWordInverseDocumentFreq(const std::string_view word) const;
+    const PostingList* FindWordDocumentFreqs(const std::string_view word) const;
 
-    template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(std::execution::sequenced_policy, const Query &query, DocumentPredicate document_predicate) const;
+    double ComputeWordInverseDocumentFreq(const Query& query, const std::string_view word, size_t document_freq) const;
 
-    template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(std::execution::parallel_policy, const Query &query, DocumentPredicate document_predicate) const;
+    std::pmr::vector<WeightedPostingList> GetWeightedPostingLists(const Query& query, std::pmr::memory_resource* resource) const;
+
+    std::vector<int> FindPhraseDocuments(const QueryPhrase& phrase) const;
+
+    bool MatchesQueryNode(const Query& query, const QueryNode& node, int document_id) const;
+    size_t EstimateQueryNodeCost(const Query& query, const QueryNode& node) const;
+    void CollectQueryNodeStatistics(const QueryNode& node, CorpusStatistics& statistics) const;
+    const std::pmr::vector<int>& GetQueryNodeDocuments(const Query& query, const QueryNode& node, std::pmr::vector<int>& storage) const;
+    std::vector<int> EvaluateQueryNode(const Query& query, const QueryNode& node) const;
+    double ComputeProximityBoost(const Query& query, int document_id) const;
+    std::pmr::vector<double> ComputeRelevances(const std::vector<int>& document_ids, const Query& query, std::pmr::vector<bool>& is_matched) const;
+
+    RoaringBitmap CollectExcludedDocuments(const Query& query) const;
+
+    size_t CountQueryPostings(const Query& query) const;
+    std::vector<Document> FindDocumentsInSet(const Query& query, std::vector<int> candidates) const;
+
+    struct Subscription {
+        std::string raw_query;
+        DocumentStatus status = DocumentStatus::ACTUAL;
+        Query query;
+        std::vector<Document> top_documents;
+        size_t evaluated_at = 0;
+        bool is_stale = false;
+        bool is_updated = false;
+    };
+
+    std::map<int, Subscription> subscriptions_;
+    SubscriptionIndex subscription_index_;
+    std::vector<int> updated_subscriptions_;
+    int next_subscription_id_ = 0;
+    size_t added_document_count_ = 0;
+    size_t subscription_refresh_interval_ = 1024;
+
+    void EvaluateSubscription(int subscription_id, Subscription& subscription);
+    void MarkSubscriptionUpdated(int subscription_id, Subscription& subscription);
+    void UpdateSubscriptions(int document_id);
+    void InvalidateSubscriptions(int document_id);
+
+    static constexpr size_t BATCH_QUERY_COUNT = 64;
+    static constexpr int BATCH_BLOCK_SIZE = 1024;
+
+    static void ForEachIndex(std::execution::sequenced_policy, size_t count, const std::function<void(size_t)>& function);
+    static void ForEachIndex(ThreadPool& pool, size_t count, const std::function<void(size_t)>& function);
+
+    template <typename Executor>
+    std::vector<std::vector<Document>> EvaluateBatch(Executor&& executor, const std::vector<std::string>& raw_queries, DocumentStatus status) const;
+
+    void EvaluateQueryBatch(const std::vector<Query>& queries, const size_t* query_ids, size_t query_count, const RoaringBitmap& allowed_documents, std::vector<std::vector<Document>>& results) const;
+
+    static int64_t QuantizeRelevance(double relevance);
+
+    static DocumentPage SelectPage(std::vector<Document> matched_documents, size_t offset, size_t limit);
+
+    static void SortTopDocuments(std::execution::sequenced_policy, std::vector<Document>& matched_documents);
+
+    static void AddRankedDocument(std::vector<Document>& ranked_documents, size_t document_limit, const Document& document);
+
+    static double GetRankedScoreThreshold(const std::vector<Document>& ranked_documents, size_t document_limit);
+
+    QueryStats PlanFilteredQuery(const Query& query, RoaringBitmap& allowed_documents, size_t thread_count) const;
+
+    template <typename Executor>
+    std::vector<Document> EvaluateFilteredQuery(Executor&& executor, const Query& query, const RoaringBitmap& allowed_documents, EvaluationStrategy strategy, size_t document_limit, const Document* after = nullptr) const;
+
+    template <typename Executor>
+    std::vector<Document> FindFilteredDocuments(Executor&& executor, const Query& query, RoaringBitmap allowed_documents, size_t document_limit, const Document* after = nullptr) const;
+
+    template <typename Executor, typename DocumentPredicate>
+    std::vector<Document> FindPredicateDocuments(Executor&& executor, const Query& query, DocumentPredicate document_predicate) const;
+
+    template <typename DocumentIdPredicate>
+    std::vector<Document> FindAllBooleanDocuments(const Query& query, DocumentIdPredicate is_allowed) const;
+
+    template <typename DocumentIdPredicate>
+    std::vector<Document> FindAllDocuments(std::execution::sequenced_policy, const Query &query, const RoaringBitmap& excluded_documents, DocumentIdPredicate is_allowed, size_t document_limit, const Document* after = nullptr) const;
+
+    template <typename DocumentIdPredicate>
+    std::vector<Document> FindAllDocuments(ThreadPool& pool, const Query &query, const RoaringBitmap& excluded_documents, DocumentIdPredicate is_allowed, size_t document_limit, const Document* after = nullptr) const;
 };
 
 template <typename StringContainer>
@@ -114,153 +349,168 @@ SearchServer::SearchServer(const StringContainer& stop_words) : stop_words_(Make
     }
 }
 
+template <typename Visitor>
+void SearchServer::ForEachDocument(Visitor visitor) const {
+    forward_index_.ForEachDocument([&](int document_id, const TermFrequency* first, const TermFrequency* last) {
+        visitor(document_id, WordFrequenciesView(term_dictionary_, first, last));
+    });
+}
+
 template <typename DocumentPredicate>
 std::vector<Document> SearchServer::FindTopDocuments(std::execution::sequenced_policy policy, const std::string_view raw_query, DocumentPredicate document_predicate) const {
-    const auto query = ParseQuery(std::execution::seq, raw_query);
-
-    auto matched_documents = FindAllDocuments(std::execution::seq, query, document_predicate);
-
-    std::sort(matched_documents.begin(), matched_documents.end(), [](const Document& lhs, const Document& rhs) {
-        if (std::abs(lhs.relevance - rhs.relevance) < MAX_REL_INNACURACY) {
-            return lhs.rating > rhs.rating;
-        } else {
-            return lhs.relevance > rhs.relevance;
-        }
-    });
-    if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-        matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
-    }
+    return FindPredicateDocuments(policy, ParseQuery(policy, raw_query), document_predicate);
+}
 
-    return matched_documents;
+template <typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopDocuments(std::execution::sequenced_policy policy, const std::string_view raw_query, DocumentPredicate document_predicate, const CorpusStatistics& statistics) const {
+    return FindPredicateDocuments(policy, ParseQuery(policy, raw_query, &statistics), document_predicate);
 }
 
 template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindTopDocuments(std::execution::parallel_policy policy, const std::string_view raw_query, DocumentPredicate document_predicate) const {
-    auto query = ParseQuery(std::execution::par, raw_query);
+std::vector<Document> SearchServer::FindTopDocuments(std::execution::parallel_policy, const std::string_view raw_query, DocumentPredicate document_predicate) const {
+    return FindTopDocuments(ThreadPool::GetDefault(), raw_query, document_predicate);
+}
 
-    sort(policy, query.plus_words.begin(), query.plus_words.end());
-    auto new_end = unique(policy, query.plus_words.begin(), query.plus_words.end());
-    query.plus_words.resize(distance(query.plus_words.begin(), new_end));
+template <typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopDocuments(ThreadPool& pool, const std::string_view raw_query, DocumentPredicate document_predicate) const {
+    return FindPredicateDocuments(pool, ParseQuery(std::execution::seq, raw_query), document_predicate);
+}
 
+template <typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_query, DocumentPredicate document_predicate) const {
+    const auto query = ParseQuery(std::execution::seq, raw_query);
+    ThreadPool& pool = ThreadPool::GetDefault();
 
-    auto matched_documents = FindAllDocuments(std::execution::par, query, document_predicate);
+    QueryStats stats;
+    stats.term_count = query.plus_words.size();
+    stats.posting_count = CountQueryPostings(query);
+    stats.candidate_count = documents_.size();
+    query_planner_.Plan(stats, false, pool.GetThreadCount());
 
-    std::sort(std::execution::par, matched_documents.begin(), matched_documents.end(), [](const Document& lhs, const Document& rhs) {
-        if (std::abs(lhs.relevance - rhs.relevance) < MAX_REL_INNACURACY) {
-            return lhs.rating > rhs.rating;
-        } else {
-            return lhs.relevance > rhs.relevance;
-        }
-    });
-    if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-        matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+    if (stats.mode == ExecutionMode::PARALLEL) {
+        return FindPredicateDocuments(pool, query, document_predicate);
     }
-
-    return matched_documents;
+    return FindPredicateDocuments(std::execution::seq, query, document_predicate);
 }
 
-template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindTopDocuments(const std::string_view raw_query, DocumentPredicate document_predicate) const {
-    return FindTopDocuments(std::execution::seq, raw_query, document_predicate);
+template <typename ExecutionPolicy>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy policy, const std::string_view raw_query) const {
+    return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
 }
 
-template <typename ExecutionPolicy>
-std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy policy, const std::string_view raw_query, DocumentStatus status) const {
-    if (std::is_same_v<ExecutionPolicy, std::execution::parallel_policy>) {
-        return FindTopDocuments(std::execution::par, raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
-            return document_status == status;
-        });
-    } else {
-        return FindTopDocuments(std::execution::seq, raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
-            return document_status == status;
-        });
+template <typename Executor>
+std::vector<Document> SearchServer::EvaluateFilteredQuery(Executor&& executor, const Query& query, const RoaringBitmap& allowed_documents, EvaluationStrategy strategy, size_t document_limit, const Document* after) const {
+    if (strategy == EvaluationStrategy::DOCUMENT_AT_A_TIME) {
+        return FindDocumentsInSet(query, allowed_documents.ToVector());
     }
+    return FindAllDocuments(executor, query, RoaringBitmap{}, [&allowed_documents](int document_id) {
+        return allowed_documents.Contains(document_id);
+    }, document_limit, after);
+}
 
+template <typename Executor>
+std::vector<Document> SearchServer::FindFilteredDocuments(Executor&& executor, const Query& query, RoaringBitmap allowed_documents, size_t document_limit, const Document* after) const {
+    const QueryStats stats = PlanFilteredQuery(query, allowed_documents, 1);
+    return EvaluateFilteredQuery(executor, query, allowed_documents, stats.strategy, document_limit, after);
 }
 
-template <typename ExecutionPolicy>
-std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy policy, const std::string_view raw_query) const {
-    auto status = DocumentStatus::ACTUAL;
-    if (std::is_same_v<ExecutionPolicy, std::execution::sequenced_policy>) {
-        return FindTopDocuments(std::execution::seq, raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
-            return document_status == status;
-        });
-    } else {
-        return FindTopDocuments(std::execution::par, raw_query, [status](int document_id, DocumentStatus document_status, int rating) {
-            return document_status == status;
-        });
-    }
+template <typename Executor, typename DocumentPredicate>
+std::vector<Document> SearchServer::FindPredicateDocuments(Executor&& executor, const Query& query, DocumentPredicate document_predicate) const {
+    auto matched_documents = FindAllDocuments(executor, query, CollectExcludedDocuments(query), [&](int document_id) {
+        const auto& document_data = documents_.at(document_id);
+        return document_predicate(document_id, document_data.status, document_data.rating);
+    }, MAX_RESULT_DOCUMENT_COUNT);
+
+    SortTopDocuments(std::execution::seq, matched_documents);
+    return matched_documents;
 }
 
-template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(std::execution::sequenced_policy, const SearchServer::Query& query, DocumentPredicate document_predicate) const {
-    std::map<int, double> document_to_relevance;
-    for (const std::string_view word : query.plus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
-            continue;
-        }
-        const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-        for (const auto& [document_id, term_freq] : word_to_document_freqs_.at(word)) {
-            const auto& document_data = documents_.at(document_id);
-            if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                document_to_relevance[document_id] += term_freq * inverse_document_freq;
-            }
-        }
-    }
+template <typename DocumentIdPredicate>
+std::vector<Document> SearchServer::FindAllBooleanDocuments(const Query& query, DocumentIdPredicate is_allowed) const {
+    std::vector<int> document_ids = EvaluateQueryNode(query, query.root);
+    document_ids.erase(std::remove_if(document_ids.begin(), document_ids.end(), [&](int document_id) {
+        return !is_allowed(document_id);
+    }), document_ids.end());
 
-    for (const std::string_view word : query.minus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
-            continue;
-        }
-        for (const auto [document_id, _] : word_to_document_freqs_.at(word)) {
-            document_to_relevance.erase(document_id);
-        }
-    }
+    ScratchArena scratch;
+    std::pmr::vector<bool> is_matched(scratch.GetResource());
+    const auto relevances = ComputeRelevances(document_ids, query, is_matched);
 
     std::vector<Document> matched_documents;
-    for (const auto [document_id, relevance] : document_to_relevance) {
-        matched_documents.push_back({ document_id, relevance, documents_.at(document_id).rating });
+    matched_documents.reserve(document_ids.size());
+    for (size_t i = 0; i < document_ids.size(); ++i) {
+        matched_documents.push_back({ document_ids[i], relevances[i], documents_.at(document_ids[i]).rating });
     }
     return matched_documents;
 }
 
+template <typename DocumentIdPredicate>
+std::vector<Document> SearchServer::FindAllDocuments(std::execution::sequenced_policy, const SearchServer::Query& query, const RoaringBitmap& excluded_documents, DocumentIdPredicate is_allowed, size_t document_limit, const Document* after) const {
+    if (query.is_boolean) {
+        return FindAllBooleanDocuments(query, is_allowed);
+    }
 
-template <typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(std::execution::parallel_policy, const SearchServer::Query& query, DocumentPredicate document_predicate) const {
-    const int BUCKET_COUNT = 150;
-    ConcurrentMap<int, double> document_to_relevance(BUCKET_COUNT);
+    ScratchArena scratch;
+    const auto terms = GetWeightedPostingLists(query, scratch.GetResource());
 
-    std::for_each(std::execution::par, query.plus_words.begin(), query.plus_words.end(), [&](const std::string_view word){
-        if (word_to_document_freqs_.count(word) == 0) {
+    std::vector<Document> matched_documents;
+    double min_score = GetRankedScoreThreshold(matched_documents, document_limit);
+    ScoreAccumulator accumulator(scratch.GetResource());
+    accumulator.Accumulate(terms, 0, INT_MAX, min_score, [&](int document_id, double relevance) {
+        if (excluded_documents.Contains(document_id) || !is_allowed(document_id)) {
             return;
         }
-        const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-
-        for (const auto &[document_id, term_freq]: word_to_document_freqs_.at(word)) {
-            const auto &document_data = documents_.at(document_id);
-            if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                document_to_relevance[document_id].ref_to_value += term_freq * inverse_document_freq;
-            }
+        const Document document = {document_id, relevance, documents_.at(document_id).rating};
+        if (after == nullptr || IsRankedHigher(*after, document)) {
+            AddRankedDocument(matched_documents, document_limit, document);
+            min_score = GetRankedScoreThreshold(matched_documents, document_limit);
         }
-
     });
+    return matched_documents;
+}
 
-    std::for_each(std::execution::par, query.minus_words.begin(), query.minus_words.end(), [&](const std::string_view word){
-        if (word_to_document_freqs_.count(word) == 0) {
-            return;
-        }
-        for (const auto [document_id, _]: word_to_document_freqs_.at(word)) {
-            document_to_relevance.erase(document_id);
-        }
-    });
+template <typename DocumentIdPredicate>
+std::vector<Document> SearchServer::FindAllDocuments(ThreadPool& pool, const SearchServer::Query& query, const RoaringBitmap& excluded_documents, DocumentIdPredicate is_allowed, size_t document_limit, const Document* after) const {
+    if (query.is_boolean) {
+        return FindAllBooleanDocuments(query, is_allowed);
+    }
 
+    ScratchArena scratch;
+    const auto terms = GetWeightedPostingLists(query, scratch.GetResource());
+    if (terms.empty()) {
+        return {};
+    }
+    int first_document_id = INT_MAX;
+    int last_document_id = 0;
+    for (const auto& term : terms) {
+        first_document_id = std::min(first_document_id, term.postings->GetDocumentIds().front());
+        last_document_id = std::max(last_document_id, term.postings->GetDocumentIds().back());
+    }
+
+    const int64_t id_span = static_cast<int64_t>(last_document_id) - first_document_id + 1;
+    const size_t range_count = static_cast<size_t>(std::min<int64_t>((pool.GetThreadCount() + 1) * 4, (id_span + ScoreAccumulator::BLOCK_SIZE - 1) / ScoreAccumulator::BLOCK_SIZE));
+    std::vector<std::vector<Document>> range_documents(range_count);
+    pool.ParallelFor(range_count, [&](size_t range) {
+        const int range_first = static_cast<int>(first_document_id + id_span * range / range_count);
+        const int range_last = static_cast<int>(first_document_id + id_span * (range + 1) / range_count - 1);
+        ScratchArena range_scratch;
+        double min_score = GetRankedScoreThreshold(range_documents[range], document_limit);
+        ScoreAccumulator accumulator(range_scratch.GetResource());
+        accumulator.Accumulate(terms, range_first, range_last, min_score, [&](int document_id, double relevance) {
+            if (excluded_documents.Contains(document_id) || !is_allowed(document_id)) {
+                return;
+            }
+            const Document document = {document_id, relevance, documents_.at(document_id).rating};
+            if (after == nullptr || IsRankedHigher(*after, document)) {
+                AddRankedDocument(range_documents[range], document_limit, document);
+                min_score = GetRankedScoreThreshold(range_documents[range], document_limit);
+            }
+        });
+    });
 
     std::vector<Document> matched_documents;
-    auto doc_to_rev = document_to_relevance.BuildOrdinaryMap();
-    for (const auto [document_id, relevance]: doc_to_rev) {
-        matched_documents.push_back({document_id, relevance, documents_.at(document_id).rating});
+    for (auto& documents : range_documents) {
+        matched_documents.insert(matched_documents.end(), documents.begin(), documents.end());
     }
-
     return matched_documents;
 }
-
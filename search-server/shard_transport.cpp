@@ -0,0 +1,47 @@
+#include "shard_transport.h"
+
+using namespace std;
+
+LocalShardTransport::LocalShardTransport(string_view stop_words_text)
+    : search_server_(stop_words_text) {
+}
+
+void LocalShardTransport::EnablePositionalIndex() {
+    search_server_.EnablePositionalIndex();
+}
+
+void LocalShardTransport::SetTextNormalization(const NormalizationOptions& options) {
+    search_server_.SetTextNormalization(options);
+}
+
+void LocalShardTransport::AddDocument(int document_id, string_view document, DocumentStatus status, const vector<int>& ratings) {
+    search_server_.AddDocument(document_id, document, status, ratings);
+}
+
+void LocalShardTransport::RemoveDocument(int document_id) {
+    search_server_.RemoveDocument(document_id);
+}
+
+int LocalShardTransport::GetDocumentCount() const {
+    return search_server_.GetDocumentCount();
+}
+
+CorpusStatistics LocalShardTransport::CollectStatistics(string_view raw_query) const {
+    return search_server_.CollectStatistics(raw_query);
+}
+
+vector<Document> LocalShardTransport::FindTopDocuments(string_view raw_query, const DocumentFilter& filter, const CorpusStatistics& statistics) const {
+    return search_server_.FindTopDocuments(execution::seq, raw_query, filter, statistics);
+}
+
+vector<Document> LocalShardTransport::FindTopDocuments(string_view raw_query, const DocumentPredicate& document_predicate, const CorpusStatistics& statistics) const {
+    return search_server_.FindTopDocuments(execution::seq, raw_query, document_predicate, statistics);
+}
+
+tuple<vector<string_view>, DocumentStatus> LocalShardTransport::MatchDocument(string_view raw_query, int document_id) const {
+    return search_server_.MatchDocument(raw_query, document_id);
+}
+
+WordFrequenciesView LocalShardTransport::GetWordFrequencies(int document_id) const {
+    return search_server_.GetWordFrequencies(document_id);
+}
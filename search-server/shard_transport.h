@@ -0,0 +1,62 @@
+#pragma once
+#include <functional>
+#include <map>
+#include <string_view>
+#include <tuple>
+#include <vector>
+#include "document.h"
+#include "search_server.h"
+
+class ShardTransport {
+public:
+    using DocumentPredicate = std::function<bool(int, DocumentStatus, int)>;
+
+    virtual ~ShardTransport() = default;
+
+    virtual void EnablePositionalIndex() = 0;
+
+    virtual void SetTextNormalization(const NormalizationOptions& options) = 0;
+
+    virtual void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings) = 0;
+
+    virtual void RemoveDocument(int document_id) = 0;
+
+    virtual int GetDocumentCount() const = 0;
+
+    virtual CorpusStatistics CollectStatistics(std::string_view raw_query) const = 0;
+
+    virtual std::vector<Document> FindTopDocuments(std::string_view raw_query, const DocumentFilter& filter, const CorpusStatistics& statistics) const = 0;
+
+    virtual std::vector<Document> FindTopDocuments(std::string_view raw_query, const DocumentPredicate& document_predicate, const CorpusStatistics& statistics) const = 0;
+
+    virtual std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::string_view raw_query, int document_id) const = 0;
+
+    virtual WordFrequenciesView GetWordFrequencies(int document_id) const = 0;
+};
+
+class LocalShardTransport : public ShardTransport {
+public:
+    explicit LocalShardTransport(std::string_view stop_words_text);
+
+    void EnablePositionalIndex() override;
+
+    void SetTextNormalization(const NormalizationOptions& options) override;
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int>& ratings) override;
+
+    void RemoveDocument(int document_id) override;
+
+    int GetDocumentCount() const override;
+
+    CorpusStatistics CollectStatistics(std::string_view raw_query) const override;
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, const DocumentFilter& filter, const CorpusStatistics& statistics) const override;
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, const DocumentPredicate& document_predicate, const CorpusStatistics& statistics) const override;
+
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::string_view raw_query, int document_id) const override;
+
+    WordFrequenciesView GetWordFrequencies(int document_id) const override;
+private:
+    SearchServer search_server_;
+};
@@ -0,0 +1,169 @@
+#include "sharded_search_server.h"
+#include <queue>
+#include <stdexcept>
+
+using namespace std;
+
+ShardedSearchServer::ShardedSearchServer(const string_view stop_words_text, size_t shard_count) {
+    if (shard_count == 0) {
+        throw invalid_argument("Shard count must be positive"s);
+    }
+    shards_.reserve(shard_count);
+    for (size_t i = 0; i < shard_count; ++i) {
+        shards_.push_back(make_unique<LocalShardTransport>(stop_words_text));
+    }
+}
+
+ShardedSearchServer::ShardedSearchServer(vector<unique_ptr<ShardTransport>> shards)
+    : shards_(move(shards)) {
+    if (shards_.empty()) {
+        throw invalid_argument("Shard count must be positive"s);
+    }
+}
+
+void ShardedSearchServer::EnablePositionalIndex() {
+    if (!document_ids_.empty()) {
+        throw logic_error("Positional index must be enabled before adding documents"s);
+    }
+    for (const auto& shard : shards_) {
+        shard->EnablePositionalIndex();
+    }
+}
+
+void ShardedSearchServer::SetTextNormalization(const NormalizationOptions& options) {
+    if (!document_ids_.empty()) {
+        throw logic_error("Text normalization must be set before adding documents"s);
+    }
+    for (const auto& shard : shards_) {
+        shard->SetTextNormalization(options);
+    }
+}
+
+void ShardedSearchServer::AddDocument(int document_id, const string_view document, DocumentStatus status, const vector<int>& ratings) {
+    GetShard(document_id).AddDocument(document_id, document, status, ratings);
+    document_ids_.Add(document_id);
+}
+
+vector<Document> ShardedSearchServer::FindTopDocuments(const string_view raw_query) const {
+    return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+}
+
+vector<Document> ShardedSearchServer::FindTopDocuments(const string_view raw_query, DocumentStatus status) const {
+    return FindTopDocuments(execution::seq, raw_query, status);
+}
+
+vector<Document> ShardedSearchServer::FindTopDocuments(const string_view raw_query, const DocumentFilter& filter) const {
+    return FindTopDocuments(execution::seq, raw_query, filter);
+}
+
+vector<Document> ShardedSearchServer::FindTopDocuments(execution::sequenced_policy policy, const string_view raw_query, DocumentStatus status) const {
+    return FindTopDocuments(policy, raw_query, DocumentFilter{{status}});
+}
+
+vector<Document> ShardedSearchServer::FindTopDocuments(execution::parallel_policy, const string_view raw_query, DocumentStatus status) const {
+    return FindTopDocuments(ThreadPool::GetDefault(), raw_query, status);
+}
+
+vector<Document> ShardedSearchServer::FindTopDocuments(execution::sequenced_policy policy, const string_view raw_query, const DocumentFilter& filter) const {
+    return ScatterGather(policy, raw_query, [&](const ShardTransport& shard, const CorpusStatistics& statistics) {
+        return shard.FindTopDocuments(raw_query, filter, statistics);
+    });
+}
+
+vector<Document> ShardedSearchServer::FindTopDocuments(execution::parallel_policy, const string_view raw_query, const DocumentFilter& filter) const {
+    return FindTopDocuments(ThreadPool::GetDefault(), raw_query, filter);
+}
+
+vector<Document> ShardedSearchServer::FindTopDocuments(ThreadPool& pool, const string_view raw_query) const {
+    return FindTopDocuments(pool, raw_query, DocumentStatus::ACTUAL);
+}
+
+vector<Document> ShardedSearchServer::FindTopDocuments(ThreadPool& pool, const string_view raw_query, DocumentStatus status) const {
+    return FindTopDocuments(pool, raw_query, DocumentFilter{{status}});
+}
+
+vector<Document> ShardedSearchServer::FindTopDocuments(ThreadPool& pool, const string_view raw_query, const DocumentFilter& filter) const {
+    return ScatterGather(pool, raw_query, [&](const ShardTransport& shard, const CorpusStatistics& statistics) {
+        return shard.FindTopDocuments(raw_query, filter, statistics);
+    });
+}
+
+int ShardedSearchServer::GetDocumentCount() const {
+    return document_ids_.Count();
+}
+
+size_t ShardedSearchServer::GetShardCount() const {
+    return shards_.size();
+}
+
+RoaringBitmap::const_iterator ShardedSearchServer::begin() const {
+    return document_ids_.begin();
+}
+
+RoaringBitmap::const_iterator ShardedSearchServer::end() const {
+    return document_ids_.end();
+}
+
+WordFrequenciesView ShardedSearchServer::GetWordFrequencies(int document_id) const {
+    return GetShard(document_id).GetWordFrequencies(document_id);
+}
+
+tuple<vector<string_view>, DocumentStatus> ShardedSearchServer::MatchDocument(const string_view raw_query, int document_id) const {
+    return GetShard(document_id).MatchDocument(raw_query, document_id);
+}
+
+tuple<vector<string_view>, DocumentStatus> ShardedSearchServer::MatchDocument(execution::parallel_policy, const string_view raw_query, int document_id) const {
+    return GetShard(document_id).MatchDocument(raw_query, document_id);
+}
+
+tuple<vector<string_view>, DocumentStatus> ShardedSearchServer::MatchDocument(execution::sequenced_policy, const string_view raw_query, int document_id) const {
+    return GetShard(document_id).MatchDocument(raw_query, document_id);
+}
+
+void ShardedSearchServer::RemoveDocument(int document_id) {
+    RemoveDocument(execution::seq, document_id);
+}
+
+void ShardedSearchServer::RemoveDocument(execution::sequenced_policy, int document_id) {
+    if (!document_ids_.Contains(document_id)) {
+        return;
+    }
+    GetShard(document_id).RemoveDocument(document_id);
+    document_ids_.Remove(document_id);
+}
+
+void ShardedSearchServer::RemoveDocument(execution::parallel_policy, int document_id) {
+    if (!document_ids_.Contains(document_id)) {
+        throw invalid_argument("invalid document id");
+    }
+    GetShard(document_id).RemoveDocument(document_id);
+    document_ids_.Remove(document_id);
+}
+
+ShardTransport& ShardedSearchServer::GetShard(int document_id) const {
+    const uint32_t hash = static_cast<uint32_t>(document_id) * 2654435761u;
+    return *shards_[hash % shards_.size()];
+}
+
+vector<Document> ShardedSearchServer::MergeTopDocuments(const vector<vector<Document>>& shard_documents) {
+    const auto is_ranked_lower = [&shard_documents](const pair<size_t, size_t>& lhs, const pair<size_t, size_t>& rhs) {
+        return SearchServer::IsRankedHigher(shard_documents[rhs.first][rhs.second], shard_documents[lhs.first][lhs.second]);
+    };
+    priority_queue<pair<size_t, size_t>, vector<pair<size_t, size_t>>, decltype(is_ranked_lower)> heads(is_ranked_lower);
+    for (size_t shard = 0; shard < shard_documents.size(); ++shard) {
+        if (!shard_documents[shard].empty()) {
+            heads.emplace(shard, 0);
+        }
+    }
+
+    vector<Document> result;
+    while (!heads.empty() && result.size() < MAX_RESULT_DOCUMENT_COUNT) {
+        const auto [shard, position] = heads.top();
+        heads.pop();
+        result.push_back(shard_documents[shard][position]);
+        if (position + 1 < shard_documents[shard].size()) {
+            heads.emplace(shard, position + 1);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,165 @@
+#pragma once
+#include <algorithm>
+#include <execution>
+#include <map>
+#include <memory>
+#include <string_view>
+#include <tuple>
+#include <vector>
+#include "document.h"
+#include "roaring_bitmap.h"
+#include "search_server.h"
+#include "shard_transport.h"
+#include "thread_pool.h"
+
+class ShardedSearchServer {
+public:
+    ShardedSearchServer(const std::string_view stop_words_text, size_t shard_count);
+
+    explicit ShardedSearchServer(std::vector<std::unique_ptr<ShardTransport>> shards);
+
+    void EnablePositionalIndex();
+
+    void SetTextNormalization(const NormalizationOptions& options);
+
+    void AddDocument(int document_id, const std::string_view document, DocumentStatus status, const std::vector<int>& ratings);
+
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query) const;
+
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query, DocumentStatus status) const;
+
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query, const DocumentFilter& filter) const;
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(const std::string_view raw_query, DocumentPredicate document_predicate) const;
+
+    std::vector<Document> FindTopDocuments(std::execution::sequenced_policy policy, const std::string_view raw_query, DocumentStatus status) const;
+    std::vector<Document> FindTopDocuments(std::execution::parallel_policy policy, const std::string_view raw_query, DocumentStatus status) const;
+
+    std::vector<Document> FindTopDocuments(std::execution::sequenced_policy policy, const std::string_view raw_query, const DocumentFilter& filter) const;
+    std::vector<Document> FindTopDocuments(std::execution::parallel_policy policy, const std::string_view raw_query, const DocumentFilter& filter) const;
+
+    template <typename ExecutionPolicy>
+    std::vector<Document> FindTopDocuments(ExecutionPolicy policy, const std::string_view raw_query) const;
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(std::execution::parallel_policy policy, const std::string_view raw_query, DocumentPredicate document_predicate) const;
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(std::execution::sequenced_policy policy, const std::string_view raw_query, DocumentPredicate document_predicate) const;
+
+    std::vector<Document> FindTopDocuments(ThreadPool& pool, const std::string_view raw_query) const;
+    std::vector<Document> FindTopDocuments(ThreadPool& pool, const std::string_view raw_query, DocumentStatus status) const;
+    std::vector<Document> FindTopDocuments(ThreadPool& pool, const std::string_view raw_query, const DocumentFilter& filter) const;
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(ThreadPool& pool, const std::string_view raw_query, DocumentPredicate document_predicate) const;
+
+    int GetDocumentCount() const;
+
+    size_t GetShardCount() const;
+
+    RoaringBitmap::const_iterator begin() const;
+    RoaringBitmap::const_iterator end() const;
+
+    WordFrequenciesView GetWordFrequencies(int document_id) const;
+
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(const std::string_view raw_query, int document_id) const;
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::execution::parallel_policy policy, const std::string_view raw_query, int document_id) const;
+    std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::execution::sequenced_policy policy, const std::string_view raw_query, int document_id) const;
+
+    void RemoveDocument(int document_id);
+    void RemoveDocument(std::execution::sequenced_policy, int document_id);
+    void RemoveDocument(std::execution::parallel_policy, int document_id);
+private:
+    std::vector<std::unique_ptr<ShardTransport>> shards_;
+    RoaringBitmap document_ids_;
+
+    ShardTransport& GetShard(int document_id) const;
+
+    template <typename ShardFunction>
+    void ForEachShard(std::execution::sequenced_policy, ShardFunction function) const;
+
+    template <typename ShardFunction>
+    void ForEachShard(ThreadPool& pool, ShardFunction function) const;
+
+    template <typename Executor>
+    CorpusStatistics CollectStatistics(Executor&& executor, const std::string_view raw_query) const;
+
+    template <typename Executor, typename ShardSearch>
+    std::vector<Document> ScatterGather(Executor&& executor, const std::string_view raw_query, ShardSearch search) const;
+
+    static std::vector<Document> MergeTopDocuments(const std::vector<std::vector<Document>>& shard_documents);
+};
+
+template <typename DocumentPredicate>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(const std::string_view raw_query, DocumentPredicate document_predicate) const {
+    return FindTopDocuments(std::execution::seq, raw_query, document_predicate);
+}
+
+template <typename ExecutionPolicy>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(ExecutionPolicy policy, const std::string_view raw_query) const {
+    return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
+}
+
+template <typename DocumentPredicate>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(std::execution::parallel_policy, const std::string_view raw_query, DocumentPredicate document_predicate) const {
+    return FindTopDocuments(ThreadPool::GetDefault(), raw_query, document_predicate);
+}
+
+template <typename DocumentPredicate>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(ThreadPool& pool, const std::string_view raw_query, DocumentPredicate document_predicate) const {
+    const ShardTransport::DocumentPredicate predicate = document_predicate;
+    return ScatterGather(pool, raw_query, [&](const ShardTransport& shard, const CorpusStatistics& statistics) {
+        return shard.FindTopDocuments(raw_query, predicate, statistics);
+    });
+}
+
+template <typename DocumentPredicate>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(std::execution::sequenced_policy policy, const std::string_view raw_query, DocumentPredicate document_predicate) const {
+    const ShardTransport::DocumentPredicate predicate = document_predicate;
+    return ScatterGather(policy, raw_query, [&](const ShardTransport& shard, const CorpusStatistics& statistics) {
+        return shard.FindTopDocuments(raw_query, predicate, statistics);
+    });
+}
+
+template <typename ShardFunction>
+void ShardedSearchServer::ForEachShard(std::execution::sequenced_policy, ShardFunction function) const {
+    for (size_t shard_index = 0; shard_index < shards_.size(); ++shard_index) {
+        function(shard_index, *shards_[shard_index]);
+    }
+}
+
+template <typename ShardFunction>
+void ShardedSearchServer::ForEachShard(ThreadPool& pool, ShardFunction function) const {
+    pool.ParallelFor(shards_.size(), [&](size_t shard_index) {
+        function(shard_index, *shards_[shard_index]);
+    });
+}
+
+template <typename Executor>
+CorpusStatistics ShardedSearchServer::CollectStatistics(Executor&& executor, const std::string_view raw_query) const {
+    std::vector<CorpusStatistics> shard_statistics(shards_.size());
+    ForEachShard(executor, [&](size_t shard_index, const ShardTransport& shard) {
+        shard_statistics[shard_index] = shard.CollectStatistics(raw_query);
+    });
+
+    CorpusStatistics statistics;
+    for (const auto& shard_statistic : shard_statistics) {
+        statistics.document_count += shard_statistic.document_count;
+        for (const auto& [word, document_freq] : shard_statistic.document_freqs) {
+            statistics.document_freqs[word] += document_freq;
+        }
+    }
+    return statistics;
+}
+
+template <typename Executor, typename ShardSearch>
+std::vector<Document> ShardedSearchServer::ScatterGather(Executor&& executor, const std::string_view raw_query, ShardSearch search) const {
+    const CorpusStatistics statistics = CollectStatistics(executor, raw_query);
+    std::vector<std::vector<Document>> shard_documents(shards_.size());
+    ForEachShard(executor, [&](size_t shard_index, const ShardTransport& shard) {
+        shard_documents[shard_index] = search(shard, statistics);
+    });
+    return MergeTopDocuments(shard_documents);
+}
@@ -0,0 +1,47 @@
+#include "subscription_index.h"
+#include <algorithm>
+
+using namespace std;
+
+void SubscriptionIndex::Add(int subscription_id, const vector<string_view>& words) {
+    for (const string_view word : words) {
+        auto it = word_to_subscriptions_.find(word);
+        if (it == word_to_subscriptions_.end()) {
+            it = word_to_subscriptions_.emplace(string(word), vector<int>{}).first;
+        }
+        vector<int>& subscription_ids = it->second;
+        const auto position = lower_bound(subscription_ids.begin(), subscription_ids.end(), subscription_id);
+        if (position == subscription_ids.end() || *position != subscription_id) {
+            subscription_ids.insert(position, subscription_id);
+        }
+    }
+}
+
+void SubscriptionIndex::Remove(int subscription_id, const vector<string_view>& words) {
+    for (const string_view word : words) {
+        const auto it = word_to_subscriptions_.find(word);
+        if (it == word_to_subscriptions_.end()) {
+            continue;
+        }
+        vector<int>& subscription_ids = it->second;
+        const auto position = lower_bound(subscription_ids.begin(), subscription_ids.end(), subscription_id);
+        if (position != subscription_ids.end() && *position == subscription_id) {
+            subscription_ids.erase(position);
+        }
+        if (subscription_ids.empty()) {
+            word_to_subscriptions_.erase(it);
+        }
+    }
+}
+
+const vector<int>* SubscriptionIndex::Find(string_view word) const {
+    const auto it = word_to_subscriptions_.find(word);
+    if (it == word_to_subscriptions_.end()) {
+        return nullptr;
+    }
+    return &it->second;
+}
+
+size_t SubscriptionIndex::size() const {
+    return word_to_subscriptions_.size();
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class SubscriptionIndex {
+public:
+    void Add(int subscription_id, const std::vector<std::string_view>& words);
+
+    void Remove(int subscription_id, const std::vector<std::string_view>& words);
+
+    const std::vector<int>* Find(std::string_view word) const;
+
+    size_t size() const;
+private:
+    std::map<std::string, std::vector<int>, std::less<>> word_to_subscriptions_;
+};
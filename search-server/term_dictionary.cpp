@@ -0,0 +1,153 @@
+#include "term_dictionary.h"
+#include <cstring>
+
+using namespace std;
+
+TermDictionary::TermDictionary() : nodes_(1) {}
+
+int TermDictionary::Insert(string_view term) {
+    const int existing_id = Find(term);
+    if (existing_id >= 0) {
+        return existing_id;
+    }
+
+    const string_view stored = StoreTerm(term);
+    const int term_id = terms_.size();
+    terms_.push_back(stored);
+
+    uint32_t node = 0;
+    size_t pos = 0;
+    while (pos < stored.size()) {
+        uint32_t previous = NO_NODE;
+        uint32_t child = nodes_[node].first_child;
+        while (child != NO_NODE && static_cast<unsigned char>(nodes_[child].label[0]) < static_cast<unsigned char>(stored[pos])) {
+            previous = child;
+            child = nodes_[child].next_sibling;
+        }
+
+        if (child == NO_NODE || nodes_[child].label[0] != stored[pos]) {
+            Node leaf;
+            leaf.label = stored.data() + pos;
+            leaf.label_length = stored.size() - pos;
+            leaf.term_id = term_id;
+            leaf.next_sibling = child;
+            const uint32_t leaf_index = nodes_.size();
+            nodes_.push_back(leaf);
+            if (previous == NO_NODE) {
+                nodes_[node].first_child = leaf_index;
+            } else {
+                nodes_[previous].next_sibling = leaf_index;
+            }
+            return term_id;
+        }
+
+        const string_view label(nodes_[child].label, nodes_[child].label_length);
+        const string_view rest = stored.substr(pos);
+        size_t common = 0;
+        while (common < label.size() && common < rest.size() && label[common] == rest[common]) {
+            ++common;
+        }
+
+        if (common < label.size()) {
+            Node middle;
+            middle.label = label.data();
+            middle.label_length = common;
+            middle.first_child = child;
+            middle.next_sibling = nodes_[child].next_sibling;
+            const uint32_t middle_index = nodes_.size();
+            nodes_.push_back(middle);
+            nodes_[child].label += common;
+            nodes_[child].label_length -= common;
+            nodes_[child].next_sibling = NO_NODE;
+            if (previous == NO_NODE) {
+                nodes_[node].first_child = middle_index;
+            } else {
+                nodes_[previous].next_sibling = middle_index;
+            }
+            child = middle_index;
+        }
+        node = child;
+        pos += common;
+    }
+    nodes_[node].term_id = term_id;
+    return term_id;
+}
+
+int TermDictionary::Find(string_view term) const {
+    uint32_t node = 0;
+    while (!term.empty()) {
+        node = FindChild(node, term[0]);
+        if (node == NO_NODE) {
+            return -1;
+        }
+        const string_view label(nodes_[node].label, nodes_[node].label_length);
+        if (term.substr(0, label.size()) != label) {
+            return -1;
+        }
+        term.remove_prefix(label.size());
+    }
+    return nodes_[node].term_id;
+}
+
+string_view TermDictionary::GetTerm(int term_id) const {
+    return terms_.at(term_id);
+}
+
+size_t TermDictionary::size() const {
+    return terms_.size();
+}
+
+MemoryUsage TermDictionary::GetMemoryUsage() const {
+    MemoryUsage usage;
+    usage.used_bytes = term_bytes_ + terms_.size() * sizeof(string_view) + nodes_.size() * sizeof(Node);
+    usage.allocated_bytes = block_bytes_ + terms_.capacity() * sizeof(string_view) + nodes_.capacity() * sizeof(Node)
+                            + blocks_.capacity() * sizeof(unique_ptr<char[]>);
+    return usage;
+}
+
+string_view TermDictionary::StoreTerm(string_view term) {
+    term_bytes_ += term.size();
+    if (term.size() > BLOCK_SIZE) {
+        block_bytes_ += term.size();
+        blocks_.push_back(make_unique<char[]>(term.size()));
+        memcpy(blocks_.back().get(), term.data(), term.size());
+        return {blocks_.back().get(), term.size()};
+    }
+    if (block_used_ + term.size() > BLOCK_SIZE) {
+        blocks_.push_back(make_unique<char[]>(BLOCK_SIZE));
+        block_used_ = 0;
+        block_bytes_ += BLOCK_SIZE;
+    }
+    char* data = blocks_.back().get() + block_used_;
+    memcpy(data, term.data(), term.size());
+    block_used_ += term.size();
+    return {data, term.size()};
+}
+
+uint32_t TermDictionary::FindChild(uint32_t node, char c) const {
+    for (uint32_t child = nodes_[node].first_child; child != NO_NODE; child = nodes_[child].next_sibling) {
+        if (nodes_[child].label[0] == c) {
+            return child;
+        }
+    }
+    return NO_NODE;
+}
+
+uint32_t TermDictionary::FindPrefixNode(string_view prefix) const {
+    uint32_t node = 0;
+    while (!prefix.empty()) {
+        node = FindChild(node, prefix[0]);
+        if (node == NO_NODE) {
+            return NO_NODE;
+        }
+        const string_view label(nodes_[node].label, nodes_[node].label_length);
+        if (prefix.size() <= label.size()) {
+            return label.substr(0, prefix.size()) == prefix ? node : NO_NODE;
+        }
+        if (prefix.substr(0, label.size()) != label) {
+            return NO_NODE;
+        }
+        prefix.remove_prefix(label.size());
+    }
+    return node;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <vector>
+#include "index_stats.h"
+
+class TermDictionary {
+public:
+    TermDictionary();
+
+    int Insert(std::string_view term);
+
+    int Find(std::string_view term) const;
+
+    std::string_view GetTerm(int term_id) const;
+
+    size_t size() const;
+
+    MemoryUsage GetMemoryUsage() const;
+
+    template <typename Callback>
+    void ForEachTermWithPrefix(std::string_view prefix, Callback callback) const;
+private:
+    static const uint32_t NO_NODE = UINT32_MAX;
+    static const size_t BLOCK_SIZE = 64 * 1024;
+
+    struct Node {
+        const char* label = nullptr;
+        uint32_t label_length = 0;
+        int term_id = -1;
+        uint32_t first_child = NO_NODE;
+        uint32_t next_sibling = NO_NODE;
+    };
+
+    std::vector<Node> nodes_;
+    std::vector<std::string_view> terms_;
+    std::vector<std::unique_ptr<char[]>> blocks_;
+    size_t block_used_ = BLOCK_SIZE;
+    size_t term_bytes_ = 0;
+    size_t block_bytes_ = 0;
+
+    std::string_view StoreTerm(std::string_view term);
+
+    uint32_t FindChild(uint32_t node, char c) const;
+
+    uint32_t FindPrefixNode(std::string_view prefix) const;
+};
+
+template <typename Callback>
+void TermDictionary::ForEachTermWithPrefix(std::string_view prefix, Callback callback) const {
+    const uint32_t subtree = FindPrefixNode(prefix);
+    if (subtree == NO_NODE) {
+        return;
+    }
+    std::vector<uint32_t> stack = {subtree};
+    while (!stack.empty()) {
+        const Node& node = nodes_[stack.back()];
+        stack.pop_back();
+        if (node.term_id >= 0 && !callback(node.term_id)) {
+            return;
+        }
+        const size_t children_begin = stack.size();
+        for (uint32_t child = node.first_child; child != NO_NODE; child = nodes_[child].next_sibling) {
+            stack.push_back(child);
+        }
+        std::reverse(stack.begin() + children_begin, stack.end());
+    }
+}
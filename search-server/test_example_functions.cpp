@@ -0,0 +1,933 @@
+#include "test_example_functions.h"
+#include "attribute_index.h"
+#include "index_stats.h"
+#include "positional_index.h"
+#include "query_planner.h"
+#include "roaring_bitmap.h"
+#include "score_accumulator.h"
+#include "search_server.h"
+#include "sharded_search_server.h"
+#include "string_processing.h"
+#include "term_dictionary.h"
+#include "text_normalizer.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+#define ASSERT(expr) AssertImpl(!!(expr), #expr, __FILE__, __FUNCTION__, __LINE__)
+
+namespace {
+
+void AssertImpl(bool value, const string& expr_str, const string& file, const string& func, unsigned line) {
+    if (!value) {
+        cerr << file << "("s << line << "): "s << func << ": "s << "ASSERT("s << expr_str << ") failed."s << endl;
+        abort();
+    }
+}
+
+RoaringBitmap MakeBitmap(const set<int>& values) {
+    RoaringBitmap bitmap;
+    for (const int value : values) {
+        bitmap.Add(value);
+    }
+    return bitmap;
+}
+
+vector<int> ToVector(const set<int>& values) {
+    return vector<int>(values.begin(), values.end());
+}
+
+vector<string> Tokenize(const NormalizationOptions& options, string_view text) {
+    const TextNormalizer normalizer(options);
+    deque<string> storage;
+    vector<string_view> tokens;
+    normalizer.Tokenize(text, storage, tokens);
+    return vector<string>(tokens.begin(), tokens.end());
+}
+
+bool HaveSameRanking(const vector<Document>& lhs, const vector<Document>& rhs) {
+    return equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](const Document& lhs_document, const Document& rhs_document) {
+        return lhs_document.id == rhs_document.id && lhs_document.rating == rhs_document.rating
+               && abs(lhs_document.relevance - rhs_document.relevance) < MAX_REL_INNACURACY;
+    });
+}
+
+set<int> GetDocumentIds(const vector<Document>& documents) {
+    set<int> document_ids;
+    for (const Document& document : documents) {
+        document_ids.insert(document.id);
+    }
+    return document_ids;
+}
+
+map<string, double> ToMap(const WordFrequenciesView& word_frequencies) {
+    map<string, double> result;
+    for (const auto [word, term_freq] : word_frequencies) {
+        result.emplace(word, term_freq);
+    }
+    return result;
+}
+
+vector<string> GenerateTestDocuments(mt19937& generator, size_t document_count) {
+    vector<string> words = {"cat"s, "cart"s, "car"s, "cab"s, "dog"s, "dig"s, "doe"s, "bird"s};
+    for (int i = 0; i < 100; ++i) {
+        words.push_back("ca"s + to_string(i));
+    }
+    vector<string> documents;
+    for (size_t i = 0; i < document_count; ++i) {
+        string document;
+        const size_t word_count = 2 + generator() % 7;
+        for (size_t j = 0; j < word_count; ++j) {
+            document += words[generator() % 8 == 0 ? 8 + generator() % 100 : generator() % 8] + ' ';
+        }
+        documents.push_back(move(document));
+    }
+    return documents;
+}
+
+}  // namespace
+
+void TestRoaringBitmap() {
+    mt19937 generator(42);
+    for (int round = 0; round < 20; ++round) {
+        set<int> lhs;
+        set<int> rhs;
+        const int range = round % 2 == 0 ? 200'000 : 5'000;
+        for (int i = 0; i < 3'000; ++i) {
+            lhs.insert(static_cast<int>(generator() % range));
+            rhs.insert(static_cast<int>(generator() % range));
+        }
+        for (int value = 70'000; value < 80'000; ++value) {
+            lhs.insert(value);
+        }
+
+        const RoaringBitmap lhs_bitmap = MakeBitmap(lhs);
+        const RoaringBitmap rhs_bitmap = MakeBitmap(rhs);
+        ASSERT(lhs_bitmap.ToVector() == ToVector(lhs));
+        ASSERT(lhs_bitmap.Count() == lhs.size());
+        ASSERT(vector<int>(lhs_bitmap.begin(), lhs_bitmap.end()) == ToVector(lhs));
+
+        set<int> expected;
+        set_intersection(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), inserter(expected, expected.end()));
+        RoaringBitmap result = lhs_bitmap;
+        result &= rhs_bitmap;
+        ASSERT(result.ToVector() == ToVector(expected));
+
+        expected.clear();
+        set_union(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), inserter(expected, expected.end()));
+        result = lhs_bitmap;
+        result |= rhs_bitmap;
+        ASSERT(result.ToVector() == ToVector(expected));
+
+        expected.clear();
+        set_difference(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), inserter(expected, expected.end()));
+        result = lhs_bitmap;
+        result -= rhs_bitmap;
+        ASSERT(result.ToVector() == ToVector(expected));
+
+        set<int> remaining = lhs;
+        RoaringBitmap removed = lhs_bitmap;
+        for (const int value : rhs) {
+            removed.Remove(value);
+            remaining.erase(value);
+        }
+        ASSERT(removed.ToVector() == ToVector(remaining));
+        for (int value = 0; value < range; value += 97) {
+            ASSERT(removed.Contains(value) == (remaining.count(value) > 0));
+        }
+    }
+    ASSERT(RoaringBitmap{}.empty());
+}
+
+void TestTermDictionary() {
+    TermDictionary dictionary;
+    const vector<string> terms = {"кот"s, "кошка"s, "котёнок"s, "пёс"s, "к"s, "cat"s, "car"s, "cart"s};
+    vector<int> term_ids;
+    for (const string& term : terms) {
+        term_ids.push_back(dictionary.Insert(term));
+    }
+    ASSERT(dictionary.size() == terms.size());
+    ASSERT(dictionary.Insert("кот"s) == term_ids[0]);
+    for (size_t i = 0; i < terms.size(); ++i) {
+        ASSERT(dictionary.Find(terms[i]) == term_ids[i]);
+        ASSERT(dictionary.GetTerm(term_ids[i]) == terms[i]);
+    }
+    ASSERT(dictionary.Find("ко"s) < 0);
+    ASSERT(dictionary.Find("котик"s) < 0);
+    ASSERT(dictionary.Find(""s) < 0);
+
+    const auto find_prefix = [&dictionary](string_view prefix) {
+        set<string_view> found;
+        dictionary.ForEachTermWithPrefix(prefix, [&](int term_id) {
+            found.insert(dictionary.GetTerm(term_id));
+            return true;
+        });
+        return found;
+    };
+    ASSERT(find_prefix("ко"s) == (set<string_view>{"кот"sv, "кошка"sv, "котёнок"sv}));
+    ASSERT(find_prefix("кот"s) == (set<string_view>{"кот"sv, "котёнок"sv}));
+    ASSERT(find_prefix("car"s) == (set<string_view>{"car"sv, "cart"sv}));
+    ASSERT(find_prefix("к"s).size() == 4);
+    ASSERT(find_prefix("собака"s).empty());
+
+    size_t visited = 0;
+    dictionary.ForEachTermWithPrefix("ка"s, [&visited](int) {
+        ++visited;
+        return true;
+    });
+    ASSERT(visited == 0);
+    dictionary.ForEachTermWithPrefix("к"s, [&visited](int) {
+        ++visited;
+        return false;
+    });
+    ASSERT(visited == 1);
+}
+
+void TestTextNormalizer() {
+    NormalizationOptions fold_case;
+    fold_case.fold_case = true;
+    ASSERT(Tokenize(fold_case, "Пушистый КОТ Ёжик Café cat"s) == (vector<string>{"пушистый"s, "кот"s, "ёжик"s, "café"s, "cat"s}));
+
+    NormalizationOptions split_punctuation;
+    split_punctuation.split_punctuation = true;
+    ASSERT(Tokenize(split_punctuation, "кот,пёс — «ёж» a.b"s) == (vector<string>{"кот"s, "пёс"s, "ёж"s, "a"s, "b"s}));
+
+    NormalizationOptions validate_utf8;
+    validate_utf8.validate_utf8 = true;
+    ASSERT(Tokenize(validate_utf8, "кот пёс"s) == (vector<string>{"кот"s, "пёс"s}));
+    for (const string& text : {"\xD0"s, "\xC0\xAF"s, "\xED\xA0\x80"s, "\xF8\x88\x80\x80\x80"s, "ab\x80"s}) {
+        try {
+            Tokenize(validate_utf8, text);
+            ASSERT(false);
+        } catch (const invalid_argument&) {
+        }
+    }
+    ASSERT(Tokenize(NormalizationOptions{}, "Кот \xD0"s) == (vector<string>{"Кот"s, "\xD0"s}));
+}
+
+void TestThreadPool() {
+    ThreadPool pool(4);
+    atomic<size_t> sum = 0;
+    pool.ParallelFor(1000, [&sum](size_t i) {
+        sum += i;
+    });
+    ASSERT(sum == 999 * 1000 / 2);
+
+    try {
+        pool.ParallelFor(100, [](size_t i) {
+            if (i == 57) {
+                throw out_of_range("task failed"s);
+            }
+        });
+        ASSERT(false);
+    } catch (const out_of_range& error) {
+        ASSERT(error.what() == "task failed"s);
+    }
+
+    sum = 0;
+    pool.ParallelFor(10, [&sum](size_t i) {
+        sum += i;
+    });
+    ASSERT(sum == 45);
+}
+
+void TestScoreKernels() {
+    mt19937 generator(37);
+    const SimdLevel supported_level = GetSimdLevel();
+    for (const SimdLevel level : {SimdLevel::AVX2, SimdLevel::AVX512}) {
+        if (level > supported_level) {
+            continue;
+        }
+        for (int round = 0; round < 50; ++round) {
+            const int block_begin = static_cast<int>(generator() % 100'000);
+            const int block_size = round % 5 == 0 ? static_cast<int>(1 + generator() % ScoreAccumulator::BLOCK_SIZE) : ScoreAccumulator::BLOCK_SIZE;
+            vector<double> scalar_scores(ScoreAccumulator::BLOCK_SIZE, 0.0);
+            vector<double> simd_scores(ScoreAccumulator::BLOCK_SIZE, 0.0);
+            vector<uint8_t> scalar_matched(ScoreAccumulator::BLOCK_SIZE, 0);
+            vector<uint8_t> simd_matched(ScoreAccumulator::BLOCK_SIZE, 0);
+            for (int term = 0; term < 3; ++term) {
+                vector<int> document_ids;
+                for (int offset = 0; offset < block_size; ++offset) {
+                    if (generator() % 3 == 0) {
+                        document_ids.push_back(block_begin + offset);
+                    }
+                }
+                vector<double> term_freqs(document_ids.size());
+                for (double& term_freq : term_freqs) {
+                    term_freq = static_cast<double>(generator() % 1000) / 997.0;
+                }
+                const double weight = static_cast<double>(generator() % 100) / 7.0;
+                ScatterAddScores(SimdLevel::SCALAR, scalar_scores.data(), scalar_matched.data(), document_ids.data(), term_freqs.data(), document_ids.size(), block_begin, weight);
+                ScatterAddScores(level, simd_scores.data(), simd_matched.data(), document_ids.data(), term_freqs.data(), document_ids.size(), block_begin, weight);
+            }
+            ASSERT(scalar_scores == simd_scores);
+            ASSERT(scalar_matched == simd_matched);
+
+            vector<uint16_t> scalar_offsets(ScoreAccumulator::BLOCK_SIZE);
+            vector<uint16_t> simd_offsets(ScoreAccumulator::BLOCK_SIZE);
+            const size_t matched_count = CollectMatchedOffsets(SimdLevel::SCALAR, scalar_matched.data(), ScoreAccumulator::BLOCK_SIZE, scalar_offsets.data());
+            ASSERT(CollectMatchedOffsets(level, scalar_matched.data(), ScoreAccumulator::BLOCK_SIZE, simd_offsets.data()) == matched_count);
+            ASSERT(equal(scalar_offsets.begin(), scalar_offsets.begin() + matched_count, simd_offsets.begin()));
+
+            for (const double min_score : {-1.0, 5.0, 20.0, 1e9}) {
+                for (const size_t count : {matched_count, matched_count / 2 + 1, size_t{3}}) {
+                    const size_t offset_count = min(count, matched_count);
+                    const size_t selected_count = SelectScoresAbove(SimdLevel::SCALAR, scalar_scores.data(), scalar_offsets.data(), offset_count, min_score, simd_offsets.data());
+                    vector<uint16_t> expected(simd_offsets.begin(), simd_offsets.begin() + selected_count);
+                    ASSERT(SelectScoresAbove(level, scalar_scores.data(), scalar_offsets.data(), offset_count, min_score, simd_offsets.data()) == selected_count);
+                    ASSERT(equal(expected.begin(), expected.end(), simd_offsets.begin()));
+                }
+            }
+        }
+    }
+}
+
+void TestShardedSearchServer() {
+    mt19937 generator(31);
+    SearchServer search_server("and"s);
+    ShardedSearchServer sharded_server("and"s, 3);
+    search_server.EnablePositionalIndex();
+    sharded_server.EnablePositionalIndex();
+    const vector<string> documents = GenerateTestDocuments(generator, 600);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        const DocumentStatus status = i % 7 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+        const vector<int> ratings = {static_cast<int>(generator() % 10)};
+        search_server.AddDocument(static_cast<int>(i), documents[i], status, ratings);
+        sharded_server.AddDocument(static_cast<int>(i), documents[i], status, ratings);
+    }
+    const vector<string> queries = {
+        "cat dog"s, "ca*"s, "dog -ca*"s, "dog -cat -car*"s, "+ca* bird"s, "+dog (cat cart)"s,
+        "bird -(ca* dig)"s, "+(dog doe) -(cart +cab)"s, "\"cat dog\""s, "bird -\"cat dog\""s,
+        "\"dog cat\"~2 ca1*"s, "+(\"car cab\" dig) -do*"s,
+    };
+    for (const string& query : queries) {
+        ASSERT(HaveSameRanking(sharded_server.FindTopDocuments(query), search_server.FindTopDocuments(query)));
+        ASSERT(HaveSameRanking(sharded_server.FindTopDocuments(execution::par, query, DocumentStatus::BANNED),
+                               search_server.FindTopDocuments(execution::seq, query, DocumentStatus::BANNED)));
+    }
+}
+
+void TestFindTopDocumentsBatch() {
+    mt19937 generator(40);
+    SearchServer search_server("and"s);
+    search_server.EnablePositionalIndex();
+    const vector<string> documents = GenerateTestDocuments(generator, 3000);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        const DocumentStatus status = i % 5 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+        search_server.AddDocument(static_cast<int>(i * 2), documents[i], status, {static_cast<int>(generator() % 3)});
+    }
+    const vector<string> words = {"cat"s, "cart"s, "car"s, "cab"s, "dog"s, "dig"s, "doe"s, "bird"s, "ca7"s, "ca*"s, "fish"s};
+    vector<string> queries;
+    for (int i = 0; i < 150; ++i) {
+        string query;
+        const size_t word_count = 1 + generator() % 4;
+        for (size_t j = 0; j < word_count; ++j) {
+            query += (generator() % 6 == 0 ? "-"s : ""s) + words[generator() % words.size()] + ' ';
+        }
+        queries.push_back(move(query));
+    }
+    queries.push_back("+dog (cat cart)"s);
+    queries.push_back("\"cat dog\" bird"s);
+    queries.push_back(""s);
+
+    ThreadPool pool(3);
+    for (const DocumentStatus status : {DocumentStatus::ACTUAL, DocumentStatus::BANNED}) {
+        const auto batch_results = search_server.FindTopDocumentsBatch(queries, status);
+        const auto pool_results = search_server.FindTopDocumentsBatch(pool, queries, status);
+        ASSERT(batch_results.size() == queries.size() && pool_results.size() == queries.size());
+        for (size_t i = 0; i < queries.size(); ++i) {
+            const auto expected = search_server.FindTopDocuments(execution::seq, queries[i], status);
+            ASSERT(HaveSameRanking(batch_results[i], expected));
+            ASSERT(HaveSameRanking(pool_results[i], expected));
+        }
+    }
+}
+
+void TestFindTopDocumentsPage() {
+    mt19937 generator(36);
+    SearchServer search_server("and"s);
+    const vector<string> documents = GenerateTestDocuments(generator, 200);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, {static_cast<int>(generator() % 3)});
+    }
+    for (int i = 0; i < 30; ++i) {
+        search_server.AddDocument(1000 + i, "cat dog bird"s, DocumentStatus::ACTUAL, {i % 2});
+    }
+
+    for (const string& query : {"cat dog"s, "bird -cart"s, "ca* doe"s}) {
+        const vector<Document> expected = search_server.FindTopDocumentsPage(query, 0, numeric_limits<size_t>::max()).documents;
+        ASSERT(expected.size() > 30);
+        for (const size_t limit : {1u, 3u, 7u}) {
+            vector<Document> by_offset;
+            vector<Document> by_cursor;
+            DocumentPage page = search_server.FindTopDocumentsPage(query, 0, limit);
+            for (size_t offset = 0; offset < expected.size(); offset += limit) {
+                const DocumentPage offset_page = search_server.FindTopDocumentsPage(query, offset, limit);
+                ASSERT(offset_page.documents.size() == min(limit, expected.size() - offset));
+                ASSERT(offset_page.next_cursor.has_value() == (offset + limit < expected.size()));
+                by_offset.insert(by_offset.end(), offset_page.documents.begin(), offset_page.documents.end());
+
+                by_cursor.insert(by_cursor.end(), page.documents.begin(), page.documents.end());
+                if (!page.next_cursor) {
+                    break;
+                }
+                page = search_server.FindTopDocumentsPage(query, *page.next_cursor, limit);
+            }
+            ASSERT(HaveSameRanking(by_offset, expected));
+            ASSERT(HaveSameRanking(by_cursor, expected));
+        }
+        ASSERT(search_server.FindTopDocumentsPage(query, expected.size(), 5).documents.empty());
+    }
+}
+
+void TestPhraseQueries() {
+    SearchServer search_server("and"s);
+    search_server.EnablePositionalIndex();
+    search_server.AddDocument(1, "new york city"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "york new city"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(3, "new big york"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(4, "new and very big old york"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(5, "city"s, DocumentStatus::ACTUAL, {1});
+
+    ASSERT(GetDocumentIds(search_server.FindTopDocuments("\"new york\""s)) == set<int>({1}));
+    ASSERT(GetDocumentIds(search_server.FindTopDocuments("\"new and york\""s)) == set<int>({1}));
+    ASSERT(GetDocumentIds(search_server.FindTopDocuments("\"new york\"~1"s)) == set<int>({1, 3}));
+    ASSERT(GetDocumentIds(search_server.FindTopDocuments("\"new york\"~3"s)) == set<int>({1, 3, 4}));
+    ASSERT(GetDocumentIds(search_server.FindTopDocuments("city -\"new york\""s)) == set<int>({2, 5}));
+    ASSERT(GetDocumentIds(search_server.FindTopDocuments("\"york\" city"s)) == set<int>({1, 2, 3, 4}));
+    ASSERT(GetDocumentIds(search_server.FindTopDocuments("city -\"york\""s)) == set<int>({5}));
+
+    const auto near_documents = search_server.FindTopDocuments("\"new york\"~3"s);
+    ASSERT(near_documents.size() == 3);
+    ASSERT(near_documents[0].id == 1 && near_documents[1].id == 3 && near_documents[2].id == 4);
+    const auto plain_documents = search_server.FindTopDocuments("+new +york"s);
+    for (const Document& document : near_documents) {
+        const auto it = find_if(plain_documents.begin(), plain_documents.end(), [&document](const Document& plain_document) {
+            return plain_document.id == document.id;
+        });
+        ASSERT(it != plain_documents.end() && document.relevance > it->relevance);
+    }
+    ASSERT(abs(near_documents[0].relevance - plain_documents[0].relevance * (1 + PHRASE_PROXIMITY_BOOST)) < MAX_REL_INNACURACY);
+
+    for (const string& query : {"\"new york"s, "\"new york\"~"s, "\"new york\"~-1"s, "\"new york\"x"s}) {
+        bool is_thrown = false;
+        try {
+            search_server.FindTopDocuments(query);
+        } catch (const invalid_argument&) {
+            is_thrown = true;
+        }
+        ASSERT(is_thrown);
+    }
+
+    SearchServer plain_server("and"s);
+    plain_server.AddDocument(1, "new york city"s, DocumentStatus::ACTUAL, {1});
+    bool is_thrown = false;
+    try {
+        plain_server.FindTopDocuments("\"new york\""s);
+    } catch (const invalid_argument&) {
+        is_thrown = true;
+    }
+    ASSERT(is_thrown);
+    ASSERT(GetDocumentIds(plain_server.FindTopDocuments("\"york\""s)) == set<int>({1}));
+
+    PositionalIndex positional_index;
+    positional_index.AddDocument(1, {7, 3, 9, 7, 8, 9});
+    ASSERT(positional_index.ContainsPhrase(1, {7, 8}, 0));
+    ASSERT(!positional_index.ContainsPhrase(1, {8, 7}, 1));
+    ASSERT(!positional_index.ContainsPhrase(1, {3, 8}, 1) && positional_index.ContainsPhrase(1, {3, 8}, 2));
+    ASSERT(positional_index.FindShortestPhraseSpan(1, {7, 9}, 5) == 2);
+    ASSERT(positional_index.FindShortestPhraseSpan(1, {3, 9, 9}, 5) == 4);
+    ASSERT(positional_index.FindShortestPhraseSpan(1, {3, 9, 9}, 1) == -1);
+    ASSERT(positional_index.FindShortestPhraseSpan(2, {7}, 0) == -1);
+}
+
+void TestDocumentFilter() {
+    mt19937 generator(29);
+    const vector<DocumentStatus> all_statuses = {DocumentStatus::ACTUAL, DocumentStatus::IRRELEVANT, DocumentStatus::BANNED, DocumentStatus::REMOVED};
+    SearchServer search_server("and"s);
+    AttributeIndex attribute_index;
+    map<int, pair<DocumentStatus, int>> attributes;
+    const vector<string> documents = GenerateTestDocuments(generator, 800);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        const int document_id = static_cast<int>(i * 3);
+        const DocumentStatus status = all_statuses[generator() % all_statuses.size()];
+        const int rating = static_cast<int>(generator() % 11) - 5;
+        search_server.AddDocument(document_id, documents[i], status, {rating});
+        attribute_index.AddDocument(document_id, status, rating);
+        attributes[document_id] = {status, rating};
+    }
+    for (int document_id = 0; document_id < 2400; document_id += 21) {
+        const auto [status, rating] = attributes.at(document_id);
+        search_server.RemoveDocument(document_id);
+        attribute_index.RemoveDocument(document_id, status, rating);
+        attributes.erase(document_id);
+    }
+
+    vector<DocumentFilter> filters = {
+        {},
+        {{DocumentStatus::ACTUAL}},
+        {{DocumentStatus::BANNED, DocumentStatus::REMOVED}},
+        {{}, 0},
+        {{}, numeric_limits<int>::min(), -3},
+        {{DocumentStatus::ACTUAL, DocumentStatus::IRRELEVANT}, -1, 2},
+        {{DocumentStatus::ACTUAL}, 5, 5},
+        {{DocumentStatus::BANNED}, 3, -3},
+        {{DocumentStatus::IRRELEVANT}, 6},
+    };
+    for (int i = 0; i < 20; ++i) {
+        DocumentFilter filter;
+        for (const DocumentStatus status : all_statuses) {
+            if (generator() % 2 == 0) {
+                filter.statuses.push_back(status);
+            }
+        }
+        filter.min_rating = static_cast<int>(generator() % 13) - 6;
+        filter.max_rating = filter.min_rating + static_cast<int>(generator() % 8);
+        filters.push_back(filter);
+    }
+
+    ThreadPool pool(3);
+    for (const DocumentFilter& filter : filters) {
+        const auto matches_filter = [&filter](int, DocumentStatus status, int rating) {
+            return (filter.statuses.empty() || count(filter.statuses.begin(), filter.statuses.end(), status) > 0)
+                   && filter.min_rating <= rating && rating <= filter.max_rating;
+        };
+        vector<int> expected_ids;
+        for (const auto& [document_id, attribute] : attributes) {
+            if (matches_filter(document_id, attribute.first, attribute.second)) {
+                expected_ids.push_back(document_id);
+            }
+        }
+        ASSERT(attribute_index.Select(filter).ToVector() == expected_ids);
+
+        for (const string& query : {"cat dog"s, "ca* -bird"s, "+dog (cat cab)"s}) {
+            const auto expected = search_server.FindTopDocuments(execution::seq, query, matches_filter);
+            for (const Document& document : expected) {
+                const auto [status, rating] = attributes.at(document.id);
+                ASSERT(matches_filter(document.id, status, rating));
+            }
+            ASSERT(HaveSameRanking(search_server.FindTopDocuments(query, filter), expected));
+            ASSERT(HaveSameRanking(search_server.FindTopDocuments(execution::seq, query, filter), expected));
+            ASSERT(HaveSameRanking(search_server.FindTopDocuments(pool, query, filter), expected));
+        }
+    }
+}
+
+void TestBooleanQueries() {
+    SearchServer search_server("and"s);
+    search_server.AddDocument(1, "a b"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "a c"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(3, "b c"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(4, "c d"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(5, "a b c d"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(6, "d"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(7, "b d"s, DocumentStatus::ACTUAL, {1});
+    const auto find_all = [&search_server](const string& query) {
+        return GetDocumentIds(search_server.FindTopDocumentsPage(query, 0, 100).documents);
+    };
+
+    ASSERT(find_all("+a"s) == set<int>({1, 2, 5}));
+    ASSERT(find_all("a -b"s) == set<int>({2}));
+    ASSERT(find_all("+a +b"s) == set<int>({1, 5}));
+    ASSERT(find_all("+a b"s) == set<int>({1, 2, 5}));
+    ASSERT(find_all("+a -b"s) == set<int>({2}));
+    ASSERT(find_all("(a b)"s) == set<int>({1, 2, 3, 5, 7}));
+    ASSERT(find_all("+(a b) +c"s) == set<int>({2, 3, 5}));
+    ASSERT(find_all("-(a b) c"s) == set<int>({4}));
+    ASSERT(find_all("-(+a +b) c"s) == set<int>({2, 3, 4}));
+    ASSERT(find_all("+d +(a (b -c))"s) == set<int>({5, 7}));
+    ASSERT(find_all("+(c +(a d))"s) == set<int>({1, 2, 4, 5, 6, 7}));
+    ASSERT(find_all("+(+(+a +c) d)"s) == set<int>({2, 5}));
+    ASSERT(find_all("+a and +c"s) == set<int>({2, 5}));
+    ASSERT(find_all("+e"s).empty());
+    ASSERT(find_all("(e f) +a"s) == set<int>({1, 2, 5}));
+
+    const auto documents = search_server.FindTopDocuments("+(a b) +c"s);
+    ASSERT(documents.size() == 3);
+    for (size_t i = 1; i < documents.size(); ++i) {
+        ASSERT(!SearchServer::IsRankedHigher(documents[i], documents[i - 1]));
+    }
+    ASSERT(documents.back().id == 5);
+
+    for (const string& query : {"(a b"s, "a b)"s, "((a) b"s, "a) (b"s, "+(a -(b c)"s}) {
+        bool is_thrown = false;
+        try {
+            search_server.FindTopDocuments(query);
+        } catch (const invalid_argument&) {
+            is_thrown = true;
+        }
+        ASSERT(is_thrown);
+    }
+}
+
+void TestPrefixQueries() {
+    SearchServer search_server("and"s);
+    for (int i = 0; i < 100; ++i) {
+        const string word = "pre"s + (i < 10 ? "0"s : ""s) + to_string(i);
+        search_server.AddDocument(i, "x "s + word + (i % 2 == 0 ? " even"s : ""s), DocumentStatus::ACTUAL, {1});
+    }
+    search_server.AddDocument(100, "prefix"s, DocumentStatus::ACTUAL, {1});
+    const auto find_all = [&search_server](const string& query) {
+        return GetDocumentIds(search_server.FindTopDocumentsPage(query, 0, 1000).documents);
+    };
+    const auto make_range = [](int first, int last) {
+        set<int> document_ids;
+        for (int i = first; i < last; ++i) {
+            document_ids.insert(i);
+        }
+        return document_ids;
+    };
+
+    ASSERT(find_all("pre*"s) == make_range(0, MAX_PREFIX_EXPANSIONS));
+    ASSERT(find_all("pre1*"s) == make_range(10, 20));
+    ASSERT(find_all("pref*"s) == set<int>({100}));
+    ASSERT(find_all("prefix*"s) == set<int>({100}));
+    ASSERT(find_all("zzz*"s).empty());
+    set<int> expected = make_range(0, 100);
+    for (int i = 10; i < 30; ++i) {
+        expected.erase(i);
+    }
+    ASSERT(find_all("x -pre1* -pre2*"s) == expected);
+    ASSERT(find_all("+even +pre9*"s) == set<int>({90, 92, 94, 96, 98}));
+    ASSERT(find_all("even -(pre0* pre1*)"s).size() == 40);
+
+    search_server.RemoveDocument(0);
+    search_server.RemoveDocument(1);
+    ASSERT(find_all("pre*"s) == make_range(2, MAX_PREFIX_EXPANSIONS + 2));
+    ASSERT(find_all("pre0*"s) == make_range(2, 10));
+
+    const auto documents = search_server.FindTopDocuments("pre1* x"s);
+    ASSERT(documents.size() == MAX_RESULT_DOCUMENT_COUNT);
+    for (const Document& document : documents) {
+        ASSERT(document.id >= 10 && document.id < 20);
+    }
+}
+
+void TestWordFrequencies() {
+    mt19937 generator(35);
+    SearchServer search_server("and"s);
+    search_server.AddDocument(1, "cat dog cat"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "and"s, DocumentStatus::BANNED, {1});
+    search_server.AddDocument(3, "bird"s, DocumentStatus::ACTUAL, {1});
+
+    const auto word_frequencies = search_server.GetWordFrequencies(1);
+    ASSERT(word_frequencies.size() == 2 && !word_frequencies.empty());
+    ASSERT(ToMap(word_frequencies) == (map<string, double>{{"cat"s, 2.0 / 3}, {"dog"s, 1.0 / 3}}));
+    ASSERT(search_server.GetWordFrequencies(2).empty());
+    ASSERT(search_server.GetWordFrequencies(4).empty() && search_server.GetWordFrequencies(4).size() == 0);
+
+    map<int, map<string, double>> expected;
+    expected[1] = ToMap(search_server.GetWordFrequencies(1));
+    expected[2] = {};
+    expected[3] = {{"bird"s, 1.0}};
+    const vector<string> documents = GenerateTestDocuments(generator, 300);
+    for (size_t i = 0; i < documents.size(); ++i) {
+        const int document_id = 10 + static_cast<int>(i);
+        search_server.AddDocument(document_id, documents[i], DocumentStatus::ACTUAL, {1});
+        map<string, double> word_counts;
+        const vector<string_view> words = SplitIntoWords(documents[i]);
+        for (const string_view word : words) {
+            word_counts[string(word)] += 1.0 / words.size();
+        }
+        expected[document_id] = move(word_counts);
+    }
+
+    const auto check_documents = [&search_server, &expected]() {
+        map<int, map<string, double>> visited;
+        search_server.ForEachDocument([&visited](int document_id, const WordFrequenciesView& word_frequencies) {
+            ASSERT(visited.count(document_id) == 0);
+            visited[document_id] = ToMap(word_frequencies);
+        });
+        ASSERT(visited.size() == expected.size() && static_cast<int>(visited.size()) == search_server.GetDocumentCount());
+        for (const auto& [document_id, word_frequencies] : expected) {
+            ASSERT(visited.count(document_id) == 1);
+            const auto& actual = visited.at(document_id);
+            ASSERT(actual.size() == word_frequencies.size());
+            for (const auto& [word, term_freq] : word_frequencies) {
+                ASSERT(actual.count(word) == 1 && abs(actual.at(word) - term_freq) < 1e-9);
+            }
+            ASSERT(search_server.GetWordFrequencies(document_id).size() == word_frequencies.size());
+        }
+    };
+    check_documents();
+
+    for (int document_id = 10; document_id < 310; document_id += 3) {
+        search_server.RemoveDocument(document_id);
+        expected.erase(document_id);
+    }
+    search_server.RemoveDocument(1);
+    expected.erase(1);
+    ASSERT(search_server.GetWordFrequencies(1).empty());
+    check_documents();
+
+    for (int document_id = 10; document_id < 310; document_id += 2) {
+        search_server.RemoveDocument(document_id);
+        expected.erase(document_id);
+    }
+    search_server.AddDocument(1, "dog dog fish"s, DocumentStatus::ACTUAL, {1});
+    expected[1] = {{"dog"s, 2.0 / 3}, {"fish"s, 1.0 / 3}};
+    check_documents();
+}
+
+void TestQueryPlanner() {
+    QueryPlannerThresholds thresholds;
+    thresholds.parallel_posting_count = 100;
+    thresholds.parallel_match_term_count = 10;
+    thresholds.candidate_cost = 1.0;
+    const QueryPlanner planner(thresholds);
+    const auto plan = [&planner](size_t posting_count, size_t candidate_count, bool has_candidates, size_t thread_count) {
+        QueryStats stats;
+        stats.term_count = 2;
+        stats.posting_count = posting_count;
+        stats.candidate_count = candidate_count;
+        planner.Plan(stats, has_candidates, thread_count);
+        return make_pair(stats.strategy, stats.mode);
+    };
+    ASSERT(plan(1000, 100, true, 4) == make_pair(EvaluationStrategy::DOCUMENT_AT_A_TIME, ExecutionMode::SEQUENTIAL));
+    ASSERT(plan(1000, 100, false, 4) == make_pair(EvaluationStrategy::TERM_AT_A_TIME, ExecutionMode::PARALLEL));
+    ASSERT(plan(1000, 100, false, 1) == make_pair(EvaluationStrategy::TERM_AT_A_TIME, ExecutionMode::SEQUENTIAL));
+    ASSERT(plan(1000, 500, true, 4) == make_pair(EvaluationStrategy::TERM_AT_A_TIME, ExecutionMode::PARALLEL));
+    ASSERT(plan(99, 500, true, 4) == make_pair(EvaluationStrategy::TERM_AT_A_TIME, ExecutionMode::SEQUENTIAL));
+    ASSERT(planner.PlanMatch(10, 2) == ExecutionMode::PARALLEL);
+    ASSERT(planner.PlanMatch(9, 2) == ExecutionMode::SEQUENTIAL);
+    ASSERT(planner.PlanMatch(10, 1) == ExecutionMode::SEQUENTIAL);
+
+    ASSERT(QueryPlanner::FitParallelThreshold({}) == numeric_limits<size_t>::max());
+    ASSERT(QueryPlanner::FitParallelThreshold({{10, 1.0, 2.0}, {50, 1.0, 2.0}, {100, 3.0, 2.0}, {200, 5.0, 2.0}}) == 100);
+    ASSERT(QueryPlanner::FitParallelThreshold({{10, 1.0, 2.0}, {200, 5.0, 6.0}}) == numeric_limits<size_t>::max());
+    ASSERT(QueryPlanner::FitParallelThreshold({{10, 1.0, 0.5}, {200, 5.0, 5.2}}) == 10);
+    ASSERT(QueryPlanner::FitParallelThreshold({{50, 1.0, 2.0}, {100, 1.0, 3.0}, {100, 3.0, 0.5}}) == 100);
+
+    SearchServer search_server("and"s);
+    for (int i = 0; i < 600; ++i) {
+        const string text = "x"s + (i % 2 == 0 ? " cat"s : ""s) + (i % 3 == 0 ? " dog"s : ""s);
+        search_server.AddDocument(i, text, DocumentStatus::ACTUAL, {i % 10});
+    }
+    search_server.SetQueryPlannerThresholds(thresholds);
+    ASSERT(search_server.GetQueryPlannerThresholds().parallel_posting_count == 100);
+    ASSERT(search_server.GetQueryPlannerThresholds().candidate_cost == 1.0);
+
+    QueryStats stats;
+    const auto expected = search_server.FindTopDocuments(execution::seq, "cat -dog"s, [](int, DocumentStatus, int) {
+        return true;
+    });
+    ASSERT(HaveSameRanking(search_server.FindTopDocuments("cat -dog"s, DocumentFilter{}, stats), expected));
+    ASSERT(stats.term_count == 1 && stats.posting_count == 300 && stats.excluded_count == 200 && stats.candidate_count == 400);
+    ASSERT(stats.strategy == EvaluationStrategy::TERM_AT_A_TIME);
+    ASSERT(stats.mode == (ThreadPool::GetDefault().GetThreadCount() > 1 ? ExecutionMode::PARALLEL : ExecutionMode::SEQUENTIAL));
+
+    const auto expected_filtered = search_server.FindTopDocuments(execution::seq, "cat -dog"s, [](int, DocumentStatus, int rating) {
+        return rating == 0;
+    });
+    ASSERT(HaveSameRanking(search_server.FindTopDocuments("cat -dog"s, DocumentFilter{{}, 0, 0}, stats), expected_filtered));
+    ASSERT(stats.candidate_count == 40 && stats.strategy == EvaluationStrategy::DOCUMENT_AT_A_TIME && stats.mode == ExecutionMode::SEQUENTIAL);
+
+    thresholds.parallel_posting_count = 1000;
+    search_server.SetQueryPlannerThresholds(thresholds);
+    ASSERT(HaveSameRanking(search_server.FindTopDocuments("cat -dog"s, DocumentFilter{}, stats), expected));
+    ASSERT(stats.strategy == EvaluationStrategy::TERM_AT_A_TIME && stats.mode == ExecutionMode::SEQUENTIAL);
+
+    const auto unchanged = search_server.CalibrateQueryPlanner({"+cat"s, "zzz"s});
+    ASSERT(unchanged.parallel_posting_count == 1000 && unchanged.candidate_cost == 1.0);
+    const auto calibrated = search_server.CalibrateQueryPlanner({"cat"s, "dog"s, "cat dog"s, "x -dog"s, "x cat dog"s});
+    ASSERT(search_server.GetQueryPlannerThresholds().parallel_posting_count == calibrated.parallel_posting_count);
+    ASSERT(search_server.GetQueryPlannerThresholds().parallel_match_term_count == calibrated.parallel_match_term_count);
+    ASSERT(search_server.GetQueryPlannerThresholds().candidate_cost == calibrated.candidate_cost);
+    ASSERT(calibrated.candidate_cost > 0.0);
+    ASSERT(HaveSameRanking(search_server.FindTopDocuments("cat -dog"s, DocumentFilter{}, stats), expected));
+}
+
+void TestIndexStats() {
+    SearchServer search_server("and"s);
+    search_server.AddDocument(1, "a b c and"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "a b b"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(3, "a"s, DocumentStatus::BANNED, {1});
+    IndexStats stats = search_server.GetIndexStats();
+    ASSERT(stats.document_count == 3 && stats.vocabulary_size == 3 && stats.total_postings == 6);
+    ASSERT(stats.posting_length_histogram == vector<size_t>({1, 2}));
+    ASSERT(stats.document_to_word_freqs.entry_count == 6 && stats.stop_words.entry_count == 1);
+    ASSERT(stats.heaviest_terms.size() == 3 && stats.heaviest_terms[0].term == "a"sv && stats.heaviest_terms[0].posting_count == 3);
+    ASSERT(stats.heaviest_terms[1].term == "b"sv && stats.heaviest_terms[2].term == "c"sv);
+
+    search_server.RemoveDocument(2);
+    search_server.RemoveDocument(2);
+    stats = search_server.GetIndexStats();
+    ASSERT(stats.document_count == 2 && stats.vocabulary_size == 3 && stats.total_postings == 4);
+    ASSERT(stats.posting_length_histogram[0] == 2 && stats.posting_length_histogram[1] == 1);
+    ASSERT(stats.word_to_document_freqs.entry_count == 4 && stats.document_to_word_freqs.entry_count == 4);
+    ASSERT(stats.documents.entry_count == 2);
+    ASSERT(stats.heaviest_terms.size() == 3 && stats.heaviest_terms[0].term == "a"sv && stats.heaviest_terms[0].posting_count == 2);
+    ASSERT(stats.heaviest_terms[1].posting_count == 1 && stats.heaviest_terms[2].posting_count == 1);
+
+    search_server.RemoveDocument(1);
+    stats = search_server.GetIndexStats();
+    ASSERT(stats.vocabulary_size == 1 && stats.total_postings == 1 && stats.term_dictionary.removed_entry_count == 2);
+    ASSERT(stats.heaviest_terms.size() == 1 && stats.heaviest_terms[0].term == "a"sv);
+    search_server.RemoveDocument(3);
+    stats = search_server.GetIndexStats();
+    ASSERT(stats.document_count == 0 && stats.vocabulary_size == 0 && stats.total_postings == 0);
+    ASSERT(stats.heaviest_terms.empty() && stats.document_to_word_freqs.entry_count == 0);
+    ASSERT(all_of(stats.posting_length_histogram.begin(), stats.posting_length_histogram.end(), [](size_t count) {
+        return count == 0;
+    }));
+
+    mt19937 generator(39);
+    const vector<string> documents = GenerateTestDocuments(generator, 1000);
+    map<int, set<string>> document_words;
+    for (size_t i = 0; i < documents.size(); ++i) {
+        search_server.AddDocument(static_cast<int>(i), documents[i], DocumentStatus::ACTUAL, {1});
+        for (const string_view word : SplitIntoWords(documents[i])) {
+            document_words[static_cast<int>(i)].insert(string(word));
+        }
+    }
+    for (int document_id = 0; document_id < 1000; document_id += 1 + static_cast<int>(generator() % 3)) {
+        search_server.RemoveDocument(document_id);
+        document_words.erase(document_id);
+    }
+
+    map<string, size_t> document_freqs;
+    for (const auto& [document_id, words] : document_words) {
+        for (const string& word : words) {
+            ++document_freqs[word];
+        }
+    }
+    size_t total_postings = 0;
+    vector<size_t> histogram;
+    for (const auto& [word, document_freq] : document_freqs) {
+        total_postings += document_freq;
+        size_t bucket = 0;
+        for (size_t length = document_freq; length > 1; length >>= 1) {
+            ++bucket;
+        }
+        histogram.resize(max(histogram.size(), bucket + 1));
+        ++histogram[bucket];
+    }
+    stats = search_server.GetIndexStats();
+    ASSERT(stats.document_count == static_cast<int>(document_words.size()));
+    ASSERT(stats.vocabulary_size == document_freqs.size() && stats.total_postings == total_postings);
+    ASSERT(stats.document_to_word_freqs.entry_count == total_postings);
+    stats.posting_length_histogram.resize(max(stats.posting_length_histogram.size(), histogram.size()));
+    histogram.resize(stats.posting_length_histogram.size());
+    ASSERT(stats.posting_length_histogram == histogram);
+    ASSERT(stats.term_dictionary.entry_count - stats.term_dictionary.removed_entry_count == document_freqs.size());
+    for (size_t i = 0; i < stats.heaviest_terms.size(); ++i) {
+        const TermCost& term = stats.heaviest_terms[i];
+        ASSERT(document_freqs.at(string(term.term)) == term.posting_count);
+        ASSERT(i == 0 || stats.heaviest_terms[i - 1].posting_count >= term.posting_count);
+    }
+}
+
+void TestSubscriptions() {
+    SearchServer search_server("and"s);
+    search_server.EnablePositionalIndex();
+    search_server.SetSubscriptionRefreshInterval(1000);
+    const int cat_dog = search_server.AddSubscription("cat dog"s, DocumentStatus::ACTUAL);
+    const int bird = search_server.AddSubscription("+bird -cat"s, DocumentStatus::ACTUAL);
+    const int red_fox = search_server.AddSubscription("\"red fox\""s, DocumentStatus::ACTUAL);
+    const int banned_cat = search_server.AddSubscription("cat"s, DocumentStatus::BANNED);
+    const map<int, pair<string, DocumentStatus>> queries = {
+        {cat_dog, {"cat dog"s, DocumentStatus::ACTUAL}},
+        {bird, {"+bird -cat"s, DocumentStatus::ACTUAL}},
+        {red_fox, {"\"red fox\""s, DocumentStatus::ACTUAL}},
+        {banned_cat, {"cat"s, DocumentStatus::BANNED}},
+    };
+    const auto find_top = [&search_server, &queries](int subscription_id) {
+        const auto& [query, status] = queries.at(subscription_id);
+        return search_server.FindTopDocuments(execution::seq, query, status);
+    };
+    ASSERT(search_server.TakeUpdatedSubscriptions().empty());
+    ASSERT(search_server.GetSubscriptionTopDocuments(cat_dog).empty());
+
+    search_server.AddDocument(1, "cat"s, DocumentStatus::ACTUAL, {1});
+    ASSERT(search_server.TakeUpdatedSubscriptions() == vector<int>({cat_dog}));
+    ASSERT(search_server.TakeUpdatedSubscriptions().empty());
+    search_server.AddDocument(2, "bird dog"s, DocumentStatus::ACTUAL, {2});
+    ASSERT(search_server.TakeUpdatedSubscriptions() == vector<int>({cat_dog, bird}));
+    search_server.AddDocument(3, "bird cat"s, DocumentStatus::ACTUAL, {3});
+    search_server.AddDocument(4, "red big fox"s, DocumentStatus::ACTUAL, {4});
+    ASSERT(search_server.TakeUpdatedSubscriptions() == vector<int>({cat_dog}));
+    search_server.AddDocument(5, "the red fox"s, DocumentStatus::ACTUAL, {5});
+    search_server.AddDocument(6, "cat"s, DocumentStatus::BANNED, {6});
+    ASSERT(search_server.TakeUpdatedSubscriptions() == vector<int>({red_fox, banned_cat}));
+    for (const auto& [subscription_id, query] : queries) {
+        ASSERT(GetDocumentIds(search_server.GetSubscriptionTopDocuments(subscription_id)) == GetDocumentIds(find_top(subscription_id)));
+    }
+
+    for (int document_id = 7; document_id < 15; ++document_id) {
+        search_server.AddDocument(document_id, "cat dog"s + (document_id % 2 == 0 ? " dog"s : ""s), DocumentStatus::ACTUAL, {document_id});
+    }
+    ASSERT(search_server.TakeUpdatedSubscriptions() == vector<int>({cat_dog}));
+    const auto& cat_dog_documents = search_server.GetSubscriptionTopDocuments(cat_dog);
+    ASSERT(cat_dog_documents.size() == MAX_RESULT_DOCUMENT_COUNT);
+    ASSERT(is_sorted(cat_dog_documents.begin(), cat_dog_documents.end(), SearchServer::IsRankedHigher));
+
+    search_server.SetSubscriptionRefreshInterval(1);
+    for (const auto& [subscription_id, query] : queries) {
+        ASSERT(HaveSameRanking(search_server.GetSubscriptionTopDocuments(subscription_id), find_top(subscription_id)));
+    }
+
+    search_server.SetSubscriptionRefreshInterval(1000);
+    search_server.RemoveDocument(2);
+    const vector<int> updated = search_server.TakeUpdatedSubscriptions();
+    ASSERT(count(updated.begin(), updated.end(), bird) == 1 && count(updated.begin(), updated.end(), red_fox) == 0);
+    ASSERT(search_server.GetSubscriptionTopDocuments(bird).empty());
+    search_server.RemoveDocument(search_server.GetSubscriptionTopDocuments(cat_dog).front().id);
+    ASSERT(search_server.TakeUpdatedSubscriptions() == vector<int>({cat_dog}));
+    ASSERT(HaveSameRanking(search_server.GetSubscriptionTopDocuments(cat_dog), find_top(cat_dog)));
+
+    search_server.RemoveSubscription(red_fox);
+    search_server.AddDocument(20, "red fox"s, DocumentStatus::ACTUAL, {1});
+    ASSERT(search_server.TakeUpdatedSubscriptions().empty());
+    for (const auto& check : vector<function<void()>>{
+            [&] { search_server.GetSubscriptionTopDocuments(red_fox); },
+            [&] { search_server.RemoveSubscription(red_fox); },
+            [&] { search_server.AddSubscription("(cat dog"s, DocumentStatus::ACTUAL); },
+        }) {
+        bool is_thrown = false;
+        try {
+            check();
+        } catch (const invalid_argument&) {
+            is_thrown = true;
+        }
+        ASSERT(is_thrown);
+    }
+    search_server.AddDocument(21, "cat"s, DocumentStatus::BANNED, {1});
+    ASSERT(search_server.TakeUpdatedSubscriptions() == vector<int>({banned_cat}));
+}
+
+void TestSearchServer() {
+    TestRoaringBitmap();
+    TestTermDictionary();
+    TestTextNormalizer();
+    TestThreadPool();
+    TestScoreKernels();
+    TestShardedSearchServer();
+    TestFindTopDocumentsBatch();
+    TestFindTopDocumentsPage();
+    TestPhraseQueries();
+    TestDocumentFilter();
+    TestBooleanQueries();
+    TestPrefixQueries();
+    TestWordFrequencies();
+    TestQueryPlanner();
+    TestIndexStats();
+    TestSubscriptions();
+}
@@ -1 +1,35 @@
 #pragma once
+
+void TestRoaringBitmap();
+
+void TestTermDictionary();
+
+void TestTextNormalizer();
+
+void TestThreadPool();
+
+void TestScoreKernels();
+
+void TestShardedSearchServer();
+
+void TestFindTopDocumentsBatch();
+
+void TestFindTopDocumentsPage();
+
+void TestPhraseQueries();
+
+void TestDocumentFilter();
+
+void TestBooleanQueries();
+
+void TestPrefixQueries();
+
+void TestWordFrequencies();
+
+void TestQueryPlanner();
+
+void TestIndexStats();
+
+void TestSubscriptions();
+
+void TestSearchServer();
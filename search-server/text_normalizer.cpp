@@ -0,0 +1,215 @@
+#include "text_normalizer.h"
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define TEXT_NORMALIZER_SSE2
+#endif
+
+using namespace std;
+
+namespace {
+
+size_t DecodeUtf8(const unsigned char* text, size_t size, char32_t& code_point) {
+    const unsigned char lead = text[0];
+    if (lead < 0x80) {
+        code_point = lead;
+        return 1;
+    }
+    size_t length = 0;
+    char32_t min_code_point = 0;
+    if ((lead & 0xE0) == 0xC0) {
+        length = 2;
+        code_point = lead & 0x1F;
+        min_code_point = 0x80;
+    } else if ((lead & 0xF0) == 0xE0) {
+        length = 3;
+        code_point = lead & 0x0F;
+        min_code_point = 0x800;
+    } else if ((lead & 0xF8) == 0xF0) {
+        length = 4;
+        code_point = lead & 0x07;
+        min_code_point = 0x10000;
+    } else {
+        return 0;
+    }
+    if (length > size) {
+        return 0;
+    }
+    for (size_t i = 1; i < length; ++i) {
+        if ((text[i] & 0xC0) != 0x80) {
+            return 0;
+        }
+        code_point = (code_point << 6) | (text[i] & 0x3F);
+    }
+    if (code_point < min_code_point || code_point > 0x10FFFF || (code_point >= 0xD800 && code_point <= 0xDFFF)) {
+        return 0;
+    }
+    return length;
+}
+
+bool IsAsciiPunctuation(unsigned char c) {
+    return (c >= 0x21 && c <= 0x2F) || (c >= 0x3A && c <= 0x40) || (c >= 0x5B && c <= 0x60) || (c >= 0x7B && c <= 0x7E);
+}
+
+bool IsPunctuation(char32_t code_point) {
+    if (code_point < 0x80) {
+        return (code_point >= '\t' && code_point <= '\r') || IsAsciiPunctuation(static_cast<unsigned char>(code_point));
+    }
+    switch (code_point) {
+    case 0xA0:
+    case 0xA1:
+    case 0xA7:
+    case 0xAB:
+    case 0xB6:
+    case 0xB7:
+    case 0xBB:
+    case 0xBF:
+    case 0x3000:
+        return true;
+    default:
+        return code_point >= 0x2000 && code_point <= 0x206F;
+    }
+}
+
+bool IsUpperCase(char32_t code_point) {
+    return (code_point >= 'A' && code_point <= 'Z')
+        || (code_point >= 0xC0 && code_point <= 0xDE && code_point != 0xD7)
+        || (code_point >= 0x400 && code_point <= 0x42F);
+}
+
+char32_t ToLowerCase(char32_t code_point) {
+    if (code_point >= 0x400 && code_point <= 0x40F) {
+        return code_point + 0x50;
+    }
+    return code_point + 0x20;
+}
+
+void FoldCase(string& token) {
+    const auto* bytes = reinterpret_cast<const unsigned char*>(token.data());
+    for (size_t i = 0; i < token.size();) {
+        char32_t code_point = 0;
+        const size_t length = DecodeUtf8(bytes + i, token.size() - i, code_point);
+        if (length == 0) {
+            ++i;
+            continue;
+        }
+        if (IsUpperCase(code_point)) {
+            const char32_t lower = ToLowerCase(code_point);
+            if (length == 1) {
+                token[i] = static_cast<char>(lower);
+            } else {
+                token[i] = static_cast<char>(0xC0 | (lower >> 6));
+                token[i + 1] = static_cast<char>(0x80 | (lower & 0x3F));
+            }
+        }
+        i += length;
+    }
+}
+
+}  // namespace
+
+TextNormalizer::TextNormalizer(const NormalizationOptions& options)
+    : options_(options) {
+}
+
+const NormalizationOptions& TextNormalizer::GetOptions() const {
+    return options_;
+}
+
+bool TextNormalizer::IsEnabled() const {
+    return options_.fold_case || options_.validate_utf8 || options_.split_punctuation;
+}
+
+void TextNormalizer::Tokenize(string_view text, deque<string>& storage, vector<string_view>& tokens) const {
+    const char* position = text.data();
+    const char* const end = text.data() + text.size();
+    const char* special = FindSpecialByte(position, end);
+    while (position != end) {
+        if (*position == ' ') {
+            ++position;
+            continue;
+        }
+        const void* space = memchr(position, ' ', end - position);
+        const char* word_end = space == nullptr ? end : static_cast<const char*>(space);
+        if (special < position) {
+            special = FindSpecialByte(position, end);
+        }
+        if (special >= word_end) {
+            tokens.emplace_back(position, word_end - position);
+        } else {
+            TokenizeWord(string_view(position, word_end - position), storage, tokens);
+        }
+        position = word_end;
+    }
+}
+
+const char* TextNormalizer::FindSpecialByte(const char* first, const char* last) const {
+#ifdef TEXT_NORMALIZER_SSE2
+    const auto in_range = [](__m128i chunk, char low, char high) {
+        return _mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8(low - 1)), _mm_cmplt_epi8(chunk, _mm_set1_epi8(high + 1)));
+    };
+    for (; last - first >= 16; first += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+        __m128i special = _mm_cmplt_epi8(chunk, _mm_set1_epi8(options_.split_punctuation ? ' ' : 0));
+        if (options_.split_punctuation) {
+            special = _mm_or_si128(special, _mm_or_si128(in_range(chunk, 0x21, 0x2F), in_range(chunk, 0x3A, 0x40)));
+            special = _mm_or_si128(special, _mm_or_si128(in_range(chunk, 0x5B, 0x60), in_range(chunk, 0x7B, 0x7E)));
+        }
+        if (options_.fold_case) {
+            special = _mm_or_si128(special, in_range(chunk, 'A', 'Z'));
+        }
+        const int mask = _mm_movemask_epi8(special);
+        if (mask != 0) {
+            return first + __builtin_ctz(mask);
+        }
+    }
+#endif
+    for (; first != last; ++first) {
+        const unsigned char c = static_cast<unsigned char>(*first);
+        if (c >= 0x80
+            || (options_.split_punctuation && (c < ' ' || IsAsciiPunctuation(c)))
+            || (options_.fold_case && c >= 'A' && c <= 'Z')) {
+            return first;
+        }
+    }
+    return last;
+}
+
+void TextNormalizer::TokenizeWord(string_view word, deque<string>& storage, vector<string_view>& tokens) const {
+    const auto* bytes = reinterpret_cast<const unsigned char*>(word.data());
+    size_t token_begin = 0;
+    bool needs_folding = false;
+    const auto add_token = [&](size_t token_end) {
+        if (token_end > token_begin) {
+            string_view token = word.substr(token_begin, token_end - token_begin);
+            if (needs_folding) {
+                string& folded = storage.emplace_back(token);
+                FoldCase(folded);
+                token = folded;
+            }
+            tokens.push_back(token);
+        }
+        needs_folding = false;
+    };
+    for (size_t i = 0; i < word.size();) {
+        char32_t code_point = 0;
+        const size_t length = DecodeUtf8(bytes + i, word.size() - i, code_point);
+        if (length == 0) {
+            if (options_.validate_utf8) {
+                throw invalid_argument("Word "s + string{word} + " is not valid UTF-8"s);
+            }
+            ++i;
+            continue;
+        }
+        if (options_.split_punctuation && IsPunctuation(code_point)) {
+            add_token(i);
+            token_begin = i + length;
+        } else if (options_.fold_case && IsUpperCase(code_point)) {
+            needs_folding = true;
+        }
+        i += length;
+    }
+    add_token(word.size());
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <deque>
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct NormalizationOptions {
+    bool fold_case = false;
+    bool validate_utf8 = false;
+    bool split_punctuation = false;
+};
+
+class TextNormalizer {
+public:
+    TextNormalizer() = default;
+
+    explicit TextNormalizer(const NormalizationOptions& options);
+
+    const NormalizationOptions& GetOptions() const;
+
+    bool IsEnabled() const;
+
+    void Tokenize(std::string_view text, std::deque<std::string>& storage, std::vector<std::string_view>& tokens) const;
+private:
+    NormalizationOptions options_;
+
+    const char* FindSpecialByte(const char* first, const char* last) const;
+
+    void TokenizeWord(std::string_view word, std::deque<std::string>& storage, std::vector<std::string_view>& tokens) const;
+};
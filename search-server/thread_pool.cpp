@@ -0,0 +1,193 @@
+#include "thread_pool.h"
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace std;
+
+static thread_local ThreadPool* current_pool = nullptr;
+static thread_local size_t current_queue = 0;
+
+ThreadPool::ThreadPool(size_t thread_count, CpuAffinity affinity) {
+    if (thread_count == 0) {
+        throw invalid_argument("Thread pool needs at least one thread"s);
+    }
+    queues_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        queues_.push_back(make_unique<WorkQueue>());
+    }
+    workers_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        workers_.emplace_back([this, i, affinity] {
+            PinCurrentThread(i, affinity);
+            WorkerLoop(i);
+        });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard guard(sleep_mutex_);
+        is_stopping_ = true;
+    }
+    wake_up_.notify_all();
+    for (thread& worker : workers_) {
+        worker.join();
+    }
+}
+
+size_t ThreadPool::GetThreadCount() const {
+    return workers_.size();
+}
+
+ThreadPool& ThreadPool::GetDefault() {
+    static ThreadPool pool(max(1u, thread::hardware_concurrency()));
+    return pool;
+}
+
+void ThreadPool::Submit(function<void()> task) {
+    const size_t queue = current_pool == this ? current_queue : next_queue_.fetch_add(1, memory_order_relaxed) % queues_.size();
+    queued_task_count_.fetch_add(1, memory_order_release);
+    {
+        lock_guard guard(queues_[queue]->mutex);
+        queues_[queue]->tasks.push_back(move(task));
+    }
+    lock_guard guard(sleep_mutex_);
+    wake_up_.notify_one();
+}
+
+bool ThreadPool::RunPendingTask() {
+    const bool is_worker = current_pool == this;
+    const size_t first_queue = is_worker ? current_queue : next_queue_.load(memory_order_relaxed);
+    for (size_t offset = 0; offset < queues_.size(); ++offset) {
+        WorkQueue& queue = *queues_[(first_queue + offset) % queues_.size()];
+        function<void()> task;
+        {
+            lock_guard guard(queue.mutex);
+            if (queue.tasks.empty()) {
+                continue;
+            }
+            if (is_worker && offset == 0) {
+                task = move(queue.tasks.back());
+                queue.tasks.pop_back();
+            } else {
+                task = move(queue.tasks.front());
+                queue.tasks.pop_front();
+            }
+        }
+        queued_task_count_.fetch_sub(1, memory_order_acq_rel);
+        task();
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::Wait(const TaskGroup& group) {
+    while (group.pending.load(memory_order_acquire) > 0) {
+        if (!RunPendingTask()) {
+            this_thread::yield();
+        }
+    }
+}
+
+void ThreadPool::WorkerLoop(size_t index) {
+    current_pool = this;
+    current_queue = index;
+    while (true) {
+        if (RunPendingTask()) {
+            continue;
+        }
+        unique_lock lock(sleep_mutex_);
+        wake_up_.wait(lock, [this] {
+            return is_stopping_ || queued_task_count_.load(memory_order_acquire) > 0;
+        });
+        if (is_stopping_ && queued_task_count_.load(memory_order_acquire) == 0) {
+            return;
+        }
+    }
+}
+
+void ThreadPool::PinCurrentThread(size_t index, CpuAffinity affinity) {
+#ifdef __linux__
+    if (affinity == CpuAffinity::NONE) {
+        return;
+    }
+    cpu_set_t available;
+    CPU_ZERO(&available);
+    if (sched_getaffinity(0, sizeof(available), &available) != 0) {
+        return;
+    }
+    vector<int> cpus;
+    if (affinity == CpuAffinity::NUMA_NODES) {
+        const auto nodes = ReadNumaNodes();
+        if (!nodes.empty()) {
+            cpus = nodes[index % nodes.size()];
+        }
+    }
+    if (cpus.empty()) {
+        vector<int> available_cpus;
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &available)) {
+                available_cpus.push_back(cpu);
+            }
+        }
+        if (available_cpus.empty()) {
+            return;
+        }
+        cpus = {available_cpus[index % available_cpus.size()]};
+    }
+
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    for (const int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE && CPU_ISSET(cpu, &available)) {
+            CPU_SET(cpu, &cpu_set);
+        }
+    }
+    if (CPU_COUNT(&cpu_set) > 0) {
+        pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+    }
+#else
+    (void)index;
+    (void)affinity;
+#endif
+}
+
+vector<int> ThreadPool::ParseCpuList(const string& text) {
+    vector<int> cpus;
+    istringstream input(text);
+    string range;
+    while (getline(input, range, ',')) {
+        if (range.empty() || range == "\n"s) {
+            continue;
+        }
+        const size_t dash = range.find('-');
+        const int first = stoi(range.substr(0, dash));
+        const int last = dash == string::npos ? first : stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+vector<vector<int>> ThreadPool::ReadNumaNodes() {
+    vector<vector<int>> nodes;
+    for (int node = 0;; ++node) {
+        ifstream input("/sys/devices/system/node/node"s + to_string(node) + "/cpulist"s);
+        if (!input) {
+            break;
+        }
+        string text;
+        getline(input, text);
+        auto cpus = ParseCpuList(text);
+        if (!cpus.empty()) {
+            nodes.push_back(move(cpus));
+        }
+    }
+    return nodes;
+}
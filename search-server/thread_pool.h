@@ -0,0 +1,105 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class CpuAffinity {
+    NONE,
+    CORES,
+    NUMA_NODES,
+};
+
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t thread_count, CpuAffinity affinity = CpuAffinity::NONE);
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool();
+
+    size_t GetThreadCount() const;
+
+    template <typename Function>
+    void ParallelFor(size_t count, Function function);
+
+    static ThreadPool& GetDefault();
+private:
+    static const size_t CHUNKS_PER_THREAD = 4;
+
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    struct TaskGroup {
+        std::atomic<size_t> pending = 0;
+        std::mutex mutex;
+        std::exception_ptr error;
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> queues_;
+    std::vector<std::thread> workers_;
+    std::atomic<size_t> queued_task_count_ = 0;
+    std::atomic<size_t> next_queue_ = 0;
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_up_;
+    bool is_stopping_ = false;
+
+    void Submit(std::function<void()> task);
+
+    bool RunPendingTask();
+
+    void Wait(const TaskGroup& group);
+
+    void WorkerLoop(size_t index);
+
+    static void PinCurrentThread(size_t index, CpuAffinity affinity);
+
+    static std::vector<int> ParseCpuList(const std::string& text);
+
+    static std::vector<std::vector<int>> ReadNumaNodes();
+};
+
+template <typename Function>
+void ThreadPool::ParallelFor(size_t count, Function function) {
+    const size_t chunk_count = std::min(count, (workers_.size() + 1) * CHUNKS_PER_THREAD);
+    if (chunk_count <= 1 || workers_.empty()) {
+        for (size_t i = 0; i < count; ++i) {
+            function(i);
+        }
+        return;
+    }
+
+    TaskGroup group;
+    group.pending = chunk_count;
+    for (size_t chunk = 0; chunk < chunk_count; ++chunk) {
+        const size_t first = count * chunk / chunk_count;
+        const size_t last = count * (chunk + 1) / chunk_count;
+        Submit([&group, &function, first, last] {
+            try {
+                for (size_t i = first; i < last; ++i) {
+                    function(i);
+                }
+            } catch (...) {
+                std::lock_guard guard(group.mutex);
+                if (!group.error) {
+                    group.error = std::current_exception();
+                }
+            }
+            group.pending.fetch_sub(1, std::memory_order_acq_rel);
+        });
+    }
+    Wait(group);
+    if (group.error) {
+        std::rethrow_exception(group.error);
+    }
+}